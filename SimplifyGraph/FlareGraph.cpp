@@ -33,26 +33,394 @@ namespace Flare {
     bool intdequeHas(const intdeque_t &s1, int n1) { return std::find(s1.begin(), s1.end(), n1) != s1.end(); }
     bool intvectorHas(const intvector_t &s1, int n1) { return std::find(s1.begin(), s1.end(), n1) != s1.end(); }
 
+    // bit of prop in the per-node property masks
+    static uint8_t propBit(NodeProperty prop) { return (uint8_t)(1 << (int)prop); }
+    static const uint8_t ROOT_BIT = 1 << (int)NodeProperty::Root;
+    static const uint8_t SENTRY_BIT = 1 << (int)NodeProperty::Sentry;
 
-    FlareGraph::FlareGraph() : rootNode(-1), functionEa(-1), edgeCount(0) {
+
+    // once the flat table would be more than this many times larger than the number
+    // of names stored in it, switch to the hash table
+    static const size_t NAME_TABLE_MAX_SPARSITY = 4;
+    static const size_t NAME_TABLE_MIN_FLAT = 1024;
+
+    int NodeNameTable::find(int name) const {
+        if (name < 0) {
+            return -1;
+        }
+        if (!hashed) {
+            if ((unsigned int)name >= flat.size()) {
+                return -1;
+            }
+            return flat[name];
+        }
+        unsigned int mask = (unsigned int)keys.size() - 1;
+        for (unsigned int i = slot(name); ; i = (i + 1) & mask) {
+            if (keys[i] == name) {
+                return values[i];
+            }
+            if (keys[i] == -1) {
+                return -1;
+            }
+        }
+    }
+
+    void NodeNameTable::insert(int name, int value) {
+        if (name < 0) {
+            return;
+        }
+        if (!hashed) {
+            if ((unsigned int)name < flat.size()) {
+                if (flat[name] == -1) {
+                    ++count;
+                }
+                flat[name] = value;
+                return;
+            }
+            size_t wanted = (size_t)name + 1;
+            if (wanted <= NAME_TABLE_MIN_FLAT || wanted <= NAME_TABLE_MAX_SPARSITY * (count + 1)) {
+                flat.resize((std::max)(wanted, flat.size() * 2), -1);
+                flat[name] = value;
+                ++count;
+                return;
+            }
+            // too sparse for the flat table, move everything over to the hash table
+            rehash((size_t)(count + 1) * 2);
+        }
+        if ((size_t)(count + 1) * 2 > keys.size()) {
+            rehash(keys.size() * 2);
+        }
+        unsigned int mask = (unsigned int)keys.size() - 1;
+        unsigned int i = slot(name);
+        while ((keys[i] != -1) && (keys[i] != name)) {
+            i = (i + 1) & mask;
+        }
+        if (keys[i] == -1) {
+            keys[i] = name;
+            ++count;
+        }
+        values[i] = value;
+    }
+
+    void NodeNameTable::clear() {
+        flat.clear();
+        keys.clear();
+        values.clear();
+        count = 0;
+        hashed = false;
+    }
+
+    // fibonacci hashing, keys.size() is always a power of 2
+    unsigned int NodeNameTable::slot(int name) const {
+        return (unsigned int)(((uint64_t)(unsigned int)name * 0x9E3779B97F4A7C15ULL) >> 32) & ((unsigned int)keys.size() - 1);
+    }
+
+    // grow (or create) the hash table, moving over the entries from the flat
+    // table or the previous hash table
+    void NodeNameTable::rehash(size_t capacity) {
+        size_t newSize = 16;
+        while (newSize < capacity) {
+            newSize *= 2;
+        }
+        intvector_t oldKeys;
+        intvector_t oldValues;
+        if (hashed) {
+            oldKeys.swap(keys);
+            oldValues.swap(values);
+        } else {
+            for (unsigned int name = 0; name < flat.size(); ++name) {
+                if (flat[name] != -1) {
+                    oldKeys.push_back((int)name);
+                    oldValues.push_back(flat[name]);
+                }
+            }
+            intvector_t().swap(flat);
+            hashed = true;
+        }
+        keys.assign(newSize, -1);
+        values.assign(newSize, -1);
+        count = 0;
+        for (unsigned int i = 0; i < oldKeys.size(); ++i) {
+            if (oldKeys[i] != -1) {
+                insert(oldKeys[i], oldValues[i]);
+            }
+        }
+    }
+
+    // size of the first workspace block. later ones double, or fit the request
+    static const size_t WORKSPACE_MIN_BLOCK = 64 * 1024;
+
+    AnalysisWorkspace::~AnalysisWorkspace() {
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            delete[] blocks[i].data;
+        }
+    }
+
+    void *AnalysisWorkspace::allocate(size_t bytes, size_t align) {
+        for (;;) {
+            if (current < blocks.size()) {
+                block_t &b = blocks[current];
+                size_t base = (size_t)b.data;
+                size_t start = ((base + used + align - 1) & ~(align - 1)) - base;
+                if (start + bytes <= b.size) {
+                    used = start + bytes;
+                    return b.data + start;
+                }
+                // the rest of this block is wasted until the next rewind
+                if (current + 1 < blocks.size()) {
+                    ++current;
+                    used = 0;
+                    continue;
+                }
+            }
+            size_t size = blocks.empty() ? WORKSPACE_MIN_BLOCK : blocks.back().size * 2;
+            size = (std::max)(size, bytes + align);
+            block_t b = { new char[size], size };
+            blocks.push_back(b);
+            ++heapAllocations;
+            current = blocks.size() - 1;
+            used = 0;
+        }
+    }
+
+    void AnalysisWorkspace::rewind(size_t block, size_t mark) {
+        --depth;
+        if ((depth == 0) && (block == 0) && (mark == 0) && (blocks.size() > 1)) {
+            // everything is free again. next time it all fits in one block
+            size_t total = getCapacity();
+            for (size_t i = 0; i < blocks.size(); ++i) {
+                delete[] blocks[i].data;
+            }
+            blocks.clear();
+            block_t b = { new char[total], total };
+            blocks.push_back(b);
+            ++heapAllocations;
+        }
+        current = block;
+        used = mark;
+    }
+
+    size_t AnalysisWorkspace::getCapacity() const {
+        size_t total = 0;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            total += blocks[i].size;
+        }
+        return total;
+    }
+
+    void NodeSet::reset(int size) {
+        universe = (size > 0) ? size : 0;
+        members = 0;
+        chunked = (universe > NODESET_DENSE_LIMIT);
+        words.clear();
+        chunkOffsets.clear();
+        if (chunked) {
+            chunkOffsets.assign((universe >> CHUNK_SHIFT) + 1, -1);
+        } else {
+            words.assign((universe + 63) >> 6, 0);
+        }
+    }
+
+    void NodeSet::clear() {
+        if (members == 0) {
+            return;
+        }
+        std::fill(words.begin(), words.end(), 0);
+        members = 0;
+    }
+
+    uint64_t *NodeSet::wordAlloc(int n) {
+        if (!chunked) {
+            return &words[n >> 6];
+        }
+        int &off = chunkOffsets[n >> CHUNK_SHIFT];
+        if (off < 0) {
+            off = (int)words.size();
+            words.resize(words.size() + CHUNK_WORDS, 0);
+        }
+        return &words[off + ((n >> 6) & (CHUNK_WORDS - 1))];
+    }
+
+    unsigned int NodeSet::chunkCount() const {
+        if (chunked) {
+            return (unsigned int)chunkOffsets.size();
+        }
+        return (unsigned int)((words.size() + CHUNK_WORDS - 1) / CHUNK_WORDS);
+    }
+
+    unsigned int NodeSet::chunkWordCount(unsigned int c) const {
+        if (chunked) {
+            return CHUNK_WORDS;
+        }
+        return (unsigned int)(std::min)((size_t)CHUNK_WORDS, words.size() - (size_t)c * CHUNK_WORDS);
+    }
+
+    const uint64_t *NodeSet::chunkWords(unsigned int c) const {
+        if (chunked) {
+            return (chunkOffsets[c] < 0) ? NULL : &words[chunkOffsets[c]];
+        }
+        return &words[(size_t)c * CHUNK_WORDS];
+    }
+
+    uint64_t *NodeSet::chunkWords(unsigned int c) {
+        return const_cast<uint64_t *>(static_cast<const NodeSet *>(this)->chunkWords(c));
+    }
+
+    void NodeSet::subtract(const NodeSet &other) {
+        unsigned int count = (std::min)(chunkCount(), other.chunkCount());
+        members = 0;
+        for (unsigned int c = 0; c < chunkCount(); ++c) {
+            uint64_t *cw = chunkWords(c);
+            if (!cw) {
+                continue;
+            }
+            unsigned int nwords = chunkWordCount(c);
+            const uint64_t *ow = (c < count) ? other.chunkWords(c) : NULL;
+            // other may be smaller, so only its own words of this chunk are read
+            unsigned int owords = ow ? (std::min)(nwords, other.chunkWordCount(c)) : 0;
+            for (unsigned int i = 0; i < nwords; ++i) {
+                if (i < owords) {
+                    cw[i] &= ~ow[i];
+                }
+                members += popcount(cw[i]);
+            }
+        }
+    }
+
+    void NodeSet::complement() {
+        members = 0;
+        for (unsigned int c = 0; c < chunkCount(); ++c) {
+            if (!chunkWords(c)) {
+                wordAlloc((int)(c << CHUNK_SHIFT));
+            }
+            uint64_t *cw = chunkWords(c);
+            unsigned int nwords = chunkWordCount(c);
+            for (unsigned int i = 0; i < nwords; ++i) {
+                cw[i] = ~cw[i];
+                // mask off the bits past the end of the universe
+                unsigned int base = (c << CHUNK_SHIFT) + (i << 6);
+                if (base + 64 > (unsigned int)universe) {
+                    cw[i] = (base >= (unsigned int)universe) ? 0 : (cw[i] & (((uint64_t)1 << (universe - base)) - 1));
+                }
+                members += popcount(cw[i]);
+            }
+        }
+    }
+
+    void NodeSet::unite(const NodeSet &other) {
+        members = 0;
+        for (unsigned int c = 0; c < chunkCount(); ++c) {
+            const uint64_t *ow = (c < other.chunkCount()) ? other.chunkWords(c) : NULL;
+            if (ow && !chunkWords(c)) {
+                wordAlloc((int)(c << CHUNK_SHIFT));
+            }
+            uint64_t *cw = chunkWords(c);
+            if (!cw) {
+                continue;
+            }
+            unsigned int nwords = chunkWordCount(c);
+            unsigned int owords = ow ? (std::min)(nwords, other.chunkWordCount(c)) : 0;
+            for (unsigned int i = 0; i < nwords; ++i) {
+                if (i < owords) {
+                    cw[i] |= ow[i];
+                }
+                members += popcount(cw[i]);
+            }
+        }
+    }
+
+    void NodeSet::toIntset(intset_t &out) const {
+        forEach([&out](int n) { out.insert(out.end(), n); });
+    }
+
+    // index of the lowest set bit, via de Bruijn multiplication so that this
+    // doesn't depend on compiler intrinsics
+    unsigned int NodeSet::lowestBit(uint64_t bits) {
+        static const unsigned char table[64] = {
+             0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+            62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+            63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+            46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6,
+        };
+        return table[((bits & (0 - bits)) * 0x03F79D71B4CB0A89ULL) >> 58];
+    }
+
+    int NodeSet::popcount(uint64_t bits) {
+        bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+        bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+        bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (int)((bits * 0x0101010101010101ULL) >> 56);
+    }
+
+    FlareGraph::FlareGraph() : structure(std::make_shared<GraphStructure>()), structureGen(1), rootsGen(1), visibleCount(0), groupStamp(0), rootNode(-1), functionEa(-1), domMode(DomMode::VirtualRoot), threadCount(0) {
     }
 
     FlareGraph::~FlareGraph() {
 
     }
 
+    FlareGraph::FlareGraph(FlareGraph &&other) : FlareGraph() {
+        swap(other);
+    }
+
+    FlareGraph &FlareGraph::operator=(FlareGraph &&other) {
+        if (this != &other) {
+            FlareGraph moved(std::move(other));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    void FlareGraph::swap(FlareGraph &other) {
+        std::swap(structure, other.structure);
+        std::swap(structureGen, other.structureGen);
+        std::swap(rootsGen, other.rootsGen);
+        for (int post = 0; post < 2; ++post) {
+            std::swap(terminalsCache[post], other.terminalsCache[post]);
+            std::swap(domTreeCache[post], other.domTreeCache[post]);
+            std::swap(domIndexCache[post], other.domIndexCache[post]);
+            std::swap(lcaCache[post], other.lcaCache[post]);
+        }
+        std::swap(rpoCache, other.rpoCache);
+        std::swap(rpoNumberCache, other.rpoNumberCache);
+        std::swap(reachCache, other.reachCache);
+        std::swap(uniqueReachCache, other.uniqueReachCache);
+        std::swap(sccCache, other.sccCache);
+        std::swap(enclosingCache, other.enclosingCache);
+        std::swap(groupLink, other.groupLink);
+        std::swap(groupSizes, other.groupSizes);
+        std::swap(groupRoot, other.groupRoot);
+        std::swap(quotientSuccs, other.quotientSuccs);
+        std::swap(quotientPreds, other.quotientPreds);
+        std::swap(contractions, other.contractions);
+        std::swap(groupMarks, other.groupMarks);
+        std::swap(visibleCount, other.visibleCount);
+        std::swap(groupStamp, other.groupStamp);
+        std::swap(nodePropBits, other.nodePropBits);
+        std::swap(nodeColorIds, other.nodeColorIds);
+        std::swap(colorNames, other.colorNames);
+        std::swap(rootNode, other.rootNode);
+        std::swap(functionEa, other.functionEa);
+        std::swap(domMode, other.domMode);
+        std::swap(threadCount, other.threadCount);
+        std::swap(sentryNodes, other.sentryNodes);
+        std::swap(sentrySlots, other.sentrySlots);
+        std::swap(inputPath, other.inputPath);
+        std::swap(walkStack, other.walkStack);
+    }
+
     bool FlareGraph::clear() {
-        preds.clear();
-        succs.clear();
-        nameMap.clear();
-        reverseNameMap.clear();
-        nodeProps.clear();
-        nodeColors.clear();
+        // the old structure may still be shared, so it's dropped rather than emptied
+        structure = std::make_shared<GraphStructure>();
+        touchStructure();
+        nodePropBits.clear();
+        nodeColorIds.clear();
+        colorNames.clear();
         rootNode = -1;
         functionEa = -1;
-        edgeCount = 0;
         sentryNodes.clear();
-        blocks.clear();
+        sentrySlots.clear();
+        clearGroups();
         return true;
     }
 
@@ -67,49 +435,149 @@ namespace Flare {
     }
 
     bool FlareGraph::load(const FlareGraph& other) {
+        if (this == &other) {
+            return true;
+        }
+        fea_t ea = other.getFunctionEa();
+        clear();
+        structure = other.structure;
+        setFunctionEa(ea);
+        return true;
+    }
+
+    GraphSnapshot FlareGraph::snapshot() {
+        freeze();
+        return structure;
+    }
+
+    bool FlareGraph::load(const GraphSnapshot &snap) {
+        if (!snap) {
+            return false;
+        }
         clear();
-        area_t area;
-        for (int i = 0; i < other.getNodeCount(); ++i) {
-            addNode(i);
-            for (int j = 0; j < other.nsucc(i); j++) {
-                int succ = other.succ(i, j);
-                addNode(succ);
-                addEdge(i, succ);
-            }
-            other.getNodeArea(i, area);
-            setNodeArea(i, area.start, area.end);
-        }
-        setFunctionEa(other.getFunctionEa());
+        // graphs only ever write to a structure they own alone, so sharing the
+        // snapshot's won't change it
+        structure = std::const_pointer_cast<GraphStructure>(snap);
+        return true;
+    }
+
+    // pack preds/succs into the flat CSR arrays. edge order within each node
+    // is preserved so traversals visit successors in the same order as before
+    bool FlareGraph::freeze() {
+        if (structure->isFrozen) {
+            return true;
+        }
+        GraphStructure &s = ownStructure();
+        const array_of_intvector_t &succs = s.succs;
+        const array_of_intvector_t &preds = s.preds;
+        FrozenGraph &frozenGraph = s.frozenGraph;
+        int count = getNodeCount();
+        frozenGraph.clear();
+        frozenGraph.succOffsets.reserve(count + 1);
+        frozenGraph.predOffsets.reserve(count + 1);
+        frozenGraph.succTargets.reserve(s.edgeCount);
+        frozenGraph.predTargets.reserve(s.edgeCount);
+        frozenGraph.succOffsets.push_back(0);
+        frozenGraph.predOffsets.push_back(0);
+        for (int i = 0; i < count; ++i) {
+            frozenGraph.succTargets.insert(frozenGraph.succTargets.end(), succs[i].begin(), succs[i].end());
+            frozenGraph.predTargets.insert(frozenGraph.predTargets.end(), preds[i].begin(), preds[i].end());
+            frozenGraph.succOffsets.push_back((int)frozenGraph.succTargets.size());
+            frozenGraph.predOffsets.push_back((int)frozenGraph.predTargets.size());
+        }
+        s.isFrozen = true;
+        DEBUGLOG("Froze graph with %d nodes and %d edges\n", count, frozenGraph.edgeCount());
         return true;
     }
 
+    void FlareGraph::touchStructure() {
+        ++structureGen;
+        ++rootsGen;
+    }
+
+    GraphStructure &FlareGraph::ownStructure() {
+        if (!structure.unique()) {
+            DEBUGLOG("Copying shared graph structure\n");
+            structure = std::make_shared<GraphStructure>(*structure);
+        }
+        return *structure;
+    }
+
+    GraphStructure &FlareGraph::editStructure() {
+        GraphStructure &s = ownStructure();
+        s.isFrozen = false;
+        touchStructure();
+        return s;
+    }
+
+    void FlareGraph::touchRoots() {
+        ++rootsGen;
+    }
+
+    void FlareGraph::sizeNodeAttrsi() {
+        size_t count = getNodeCount();
+        if (nodePropBits.size() < count) {
+            nodePropBits.resize(count, 0);
+            nodeColorIds.resize(count, 0);
+            sentrySlots.resize(count, -1);
+        }
+    }
+
+    const FrozenGraph &FlareGraph::frozen() {
+        if (!structure->isFrozen) {
+            freeze();
+        }
+        return structure->frozenGraph;
+    }
+
+    int FlareGraph::walkSuccsi(int start, NodeSet &seen, const NodeSet *blocked) {
+        walkStack.clear();
+        walkStack.push_back(start);
+        return walkFromStacki(seen, blocked);
+    }
+
+    int FlareGraph::walkSuccsi(const intvector_t &starts, NodeSet &seen, const NodeSet *blocked) {
+        walkStack.assign(starts.begin(), starts.end());
+        return walkFromStacki(seen, blocked);
+    }
+
+    // walks from the start nodes already on walkStack
+    int FlareGraph::walkFromStacki(NodeSet &seen, const NodeSet *blocked) {
+        const FrozenGraph &fg = frozen();
+        if (blocked) {
+            return walk<SuccDir>(fg, walkStack, seen, SkipNodes(*blocked), NoVisit());
+        }
+        return walk<SuccDir>(fg, walkStack, seen, AllNodes(), NoVisit());
+    }
+
     bool FlareGraph::setFilePath(const char* path) {
         inputPath = path;
         return true;
     }
 
     int FlareGraph::mapNode(int name) const {
-        auto it = nameMap.find(name);
-        if (it == nameMap.end()) {
-            return -1;
+        if (structure->identityNames) {
+            return ((unsigned int)name < structure->succs.size()) ? name : -1;
         }
-        return it->second;
+        return structure->nameMap.find(name);
     }
 
     int FlareGraph::reverseMapNode(int name) const {
-        auto it = reverseNameMap.find(name);
-        if (it == reverseNameMap.end()) {
+        if ((unsigned int)name >= structure->succs.size()) {
             return -1;
         }
-        return it->second;
+        if (structure->identityNames) {
+            return name;
+        }
+        return structure->reverseNameMap[name];
     }
 
     int FlareGraph::nsucci(int in1) const {
-        return (int)(succs[in1].size());
+        return (int)(structure->succs[in1].size());
     }
 
     int FlareGraph::npredi(int in1) const {
-        return (int)(preds[in1].size());
+        return (int)(structure->preds[in1].size());
     }
 
     int FlareGraph::nsucc(int name) const {
@@ -129,17 +597,19 @@ namespace Flare {
     }
 
     int FlareGraph::succi(int in1, int idx) const {
-        if ((unsigned int)idx >= succs[in1].size()) {
+        const intvector_t &succs = structure->succs[in1];
+        if ((unsigned int)idx >= succs.size()) {
             return -1;
         }
-        return succs[in1][idx];
+        return succs[idx];
     }
 
     int FlareGraph::predi(int in1, int idx) const {
-        if ((unsigned int)idx >= preds[in1].size()) {
+        const intvector_t &preds = structure->preds[in1];
+        if ((unsigned int)idx >= preds.size()) {
             return -1;
         }
-        return preds[in1][idx];
+        return preds[idx];
     }
 
     int FlareGraph::succ(int name, int idx) const {
@@ -159,7 +629,7 @@ namespace Flare {
     }
 
     int FlareGraph::getNodeCount() const {
-        return (int)(succs.size());
+        return structure->getNodeCount();
     }
 
     bool FlareGraph::getNodeArea(int n1, area_t &area) const {
@@ -168,8 +638,7 @@ namespace Flare {
             // bad names
             return false;
         }
-        area.start = blocks[in1].start;
-        area.end = blocks[in1].end;
+        area = structure->blocks[in1];
         return true;
     }
 
@@ -179,7 +648,7 @@ namespace Flare {
             // bad names
             return false;
         }
-        return blocks[in1].start;
+        return structure->blocks[in1].start;
     }
 
     fea_t FlareGraph::getNodeAreaEnd(int n1) const {
@@ -188,7 +657,7 @@ namespace Flare {
             // bad names
             return false;
         }
-        return blocks[in1].end;
+        return structure->blocks[in1].end;
     }
 
     // returns True if an edge n1->n2 exists (in n1's successor set)
@@ -200,7 +669,8 @@ namespace Flare {
             // bad names
             return false;
         }
-        if (std::find(succs[in1].begin(), succs[in1].end(), in2) == succs[in1].end()) {
+        const intvector_t &succs = structure->succs[in1];
+        if (std::find(succs.begin(), succs.end(), in2) == succs.end()) {
             // edge n1->n2 is NOT in in1's successor set
             return false;
         }
@@ -216,7 +686,8 @@ namespace Flare {
             // bad names
             return false;
         }
-        if (std::find(preds[in2].begin(), preds[in2].end(), in1) == preds[in2].end()) {
+        const intvector_t &preds = structure->preds[in2];
+        if (std::find(preds.begin(), preds.end(), in1) == preds.end()) {
             // edge n1->n2 NOT in in2's predecessor set1
             return false;
         }
@@ -230,20 +701,33 @@ namespace Flare {
             LOG("Bad name: %d", name);
             return -1;
         }
-        if (mapNode(name) != -1) {
+        int existing = mapNode(name);
+        if (existing != -1) {
             // name already exists
-            DEBUGLOG("node %d already exists: %d\n", name, mapNode(name));
-            return nameMap[name];
+            DEBUGLOG("node %d already exists: %d\n", name, existing);
+            return existing;
+        }
+        GraphStructure &s = editStructure();
+        int newNode = (int)(s.succs.size());
+        if (s.identityNames && (name != newNode)) {
+            // first name that doesn't match its internal name. from now on, we need
+            // the real tables, so fill them in for all existing nodes
+            for (int i = 0; i < newNode; ++i) {
+                s.nameMap.insert(i, i);
+                s.reverseNameMap.push_back(i);
+            }
+            s.identityNames = false;
         }
         intvector_t newveca;
         intvector_t newvecb;
-        succs.push_back(newveca);
-        preds.push_back(newvecb);
+        s.succs.push_back(newveca);
+        s.preds.push_back(newvecb);
         area_t a1 = { 0 };
-        blocks.push_back(a1);
-        int newNode = (int)(succs.size()) - 1;
-        nameMap[name] = newNode;
-        reverseNameMap[newNode] = name;
+        s.blocks.push_back(a1);
+        if (!s.identityNames) {
+            s.nameMap.insert(name, newNode);
+            s.reverseNameMap.push_back(name);
+        }
         DEBUGLOG("Added new node ext %d(int %d)\n", name, newNode);
         return newNode;
     }
@@ -257,8 +741,9 @@ namespace Flare {
         if (in1 < 0) {
             return false;
         }
-        blocks[in1].start = start;
-        blocks[in1].end = end;
+        area_t &block = ownStructure().blocks[in1];
+        block.start = start;
+        block.end = end;
         return true;
     }
 
@@ -271,29 +756,168 @@ namespace Flare {
             LOG("Bad edge names %d %d\n", n1, n2);
             return false;
         }
-        if (std::find(succs[in1].begin(), succs[in1].end(), in2) != succs[in1].end()) {
+        const intvector_t &succs = structure->succs[in1];
+        const intvector_t &preds = structure->preds[in2];
+        if (std::find(succs.begin(), succs.end(), in2) != succs.end()) {
             // edge already in in1's successor set
             LOG("Edge %d -> %d already exists\n", n1, n2);
             return false;
         }
-        if (std::find(preds[in2].begin(), preds[in2].end(), in1) != preds[in2].end()) {
+        if (std::find(preds.begin(), preds.end(), in1) != preds.end()) {
             LOG("Edge %d -> %d already exists\n", n1, n2);
             // edge already in in2's predecssor set
             return false;
         }
         DEBUGLOG("Added edge %d -> %d\n", n1, n2);
-        succs[in1].push_back(in2);
-        preds[in2].push_back(in1);
-        ++edgeCount;
+        GraphStructure &s = editStructure();
+        s.succs[in1].push_back(in2);
+        s.preds[in2].push_back(in1);
+        ++s.edgeCount;
+        return true;
+    }
+
+    bool FlareGraph::addNodes(const intvector_t &names) {
+        for (auto it = names.begin(); it != names.end(); ++it) {
+            if (*it < 0) {
+                LOG("Bad name: %d\n", *it);
+                return false;
+            }
+        }
+        if (!names.empty()) {
+            GraphStructure &s = ownStructure();
+            s.succs.reserve(s.succs.size() + names.size());
+            s.preds.reserve(s.preds.size() + names.size());
+            s.blocks.reserve(s.blocks.size() + names.size());
+        }
+        for (auto it = names.begin(); it != names.end(); ++it) {
+            addNode(*it);
+        }
+        return true;
+    }
+
+    // the new edges are bucketed by source with a stable counting sort. for each
+    // source, its existing successors and then its new edges are stamped in
+    // seen, which flags every repeat in one pass. the survivors are then appended
+    // in input order, so the adjacency comes out exactly as addEdge() would leave it
+    bool FlareGraph::addEdges(const intvector_t &sources, const intvector_t &targets) {
+        if (sources.size() != targets.size()) {
+            LOG("Edge lists differ in size: %d sources, %d targets\n", (int)sources.size(), (int)targets.size());
+            return false;
+        }
+        int count = getNodeCount();
+        size_t edges = sources.size();
+        intvector_t in1s(edges);
+        intvector_t in2s(edges);
+        intvector_t offsets(count + 1, 0);
+        for (size_t e = 0; e < edges; ++e) {
+            in1s[e] = mapNode(sources[e]);
+            in2s[e] = mapNode(targets[e]);
+            if ((in1s[e] < 0) || (in2s[e] < 0)) {
+                LOG("Bad edge names %d %d\n", sources[e], targets[e]);
+                return false;
+            }
+            ++offsets[in1s[e] + 1];
+        }
+        for (int i = 0; i < count; ++i) {
+            offsets[i + 1] += offsets[i];
+        }
+        intvector_t bucket(edges);
+        intvector_t fill(offsets.begin(), offsets.end() - 1);
+        for (size_t e = 0; e < edges; ++e) {
+            bucket[fill[in1s[e]]++] = (int)e;
+        }
+
+        intvector_t seen(count, -1);
+        intvector_t newSuccs(count, 0);
+        intvector_t newPreds(count, 0);
+        std::vector<char> keep(edges, 0);
+        int added = 0;
+        for (int in1 = 0; in1 < count; ++in1) {
+            if (offsets[in1] == offsets[in1 + 1]) {
+                continue;
+            }
+            const intvector_t &succs = structure->succs[in1];
+            for (auto it = succs.begin(); it != succs.end(); ++it) {
+                seen[*it] = in1;
+            }
+            for (int k = offsets[in1]; k < offsets[in1 + 1]; ++k) {
+                int e = bucket[k];
+                if (seen[in2s[e]] != in1) {
+                    seen[in2s[e]] = in1;
+                    keep[e] = 1;
+                    ++newSuccs[in1];
+                    ++newPreds[in2s[e]];
+                    ++added;
+                }
+            }
+        }
+        DEBUGLOG("Adding %d of %d edges, the rest already exist\n", added, (int)edges);
+        if (added == 0) {
+            return true;
+        }
+        GraphStructure &s = editStructure();
+        for (int i = 0; i < count; ++i) {
+            if (newSuccs[i] != 0) {
+                s.succs[i].reserve(s.succs[i].size() + newSuccs[i]);
+            }
+            if (newPreds[i] != 0) {
+                s.preds[i].reserve(s.preds[i].size() + newPreds[i]);
+            }
+        }
+        for (size_t e = 0; e < edges; ++e) {
+            if (keep[e]) {
+                s.succs[in1s[e]].push_back(in2s[e]);
+                s.preds[in2s[e]].push_back(in1s[e]);
+            }
+        }
+        s.edgeCount += added;
         return true;
     }
 
+    bool FlareGraph::addEdges(const std::vector<intintPair_t> &edges) {
+        intvector_t sources;
+        intvector_t targets;
+        sources.reserve(edges.size());
+        targets.reserve(edges.size());
+        for (auto it = edges.begin(); it != edges.end(); ++it) {
+            sources.push_back(it->first);
+            targets.push_back(it->second);
+        }
+        return addEdges(sources, targets);
+    }
+
+    bool FlareGraph::build(int nodeCount, const intvector_t &sources, const intvector_t &targets) {
+        clear();
+        if (nodeCount < 0) {
+            LOG("Bad node count: %d\n", nodeCount);
+            return false;
+        }
+        // dense names are the internal names, so there is nothing to map
+        GraphStructure &s = editStructure();
+        s.succs.resize(nodeCount);
+        s.preds.resize(nodeCount);
+        area_t a1 = { 0 };
+        s.blocks.assign(nodeCount, a1);
+        return addEdges(sources, targets);
+    }
+
     bool FlareGraph::colorNode(int n1, const char* color) {
         int in1 = mapNode(n1);
         if (in1 < 0) {
             return false;
         }
-        nodeColors[in1] = std::string(color);
+        // colors come from a small palette, so a linear search interns them
+        std::string name(color);
+        size_t id = std::find(colorNames.begin(), colorNames.end(), name) - colorNames.begin();
+        if (id == colorNames.size()) {
+            if (id >= 0xffff) {
+                LOG("Too many node colors\n");
+                return false;
+            }
+            colorNames.push_back(name);
+        }
+        sizeNodeAttrsi();
+        nodeColorIds[in1] = (uint16_t)(id + 1);
         return true;
     }
 
@@ -316,17 +940,24 @@ namespace Flare {
             // bad names
             return false;
         }
-        nodeProps[in1].erase(prop);
+        sizeNodeAttrsi();
+        uint8_t bit = propBit(prop);
+        if ((nodePropBits[in1] & bit) == 0) {
+            return true;
+        }
+        nodePropBits[in1] &= ~bit;
         if (prop == NodeProperty::Root) {
             rootNode = -1;
+            touchRoots();
         } else if (prop == NodeProperty::Sentry) {
-#if 0
-            // orange TODO
-            auto it = sentryNodes.find(in1);
-            if (it != sentryNodes.end()) {
-                sentryNodes.erase(it);
-            }
-#endif 
+            // move the last sentry into in1's slot
+            int slot = sentrySlots[in1];
+            int last = sentryNodes.back();
+            sentryNodes[slot] = last;
+            sentrySlots[last] = slot;
+            sentryNodes.pop_back();
+            sentrySlots[in1] = -1;
+            touchRoots();
         }
         return true;
     }
@@ -338,32 +969,55 @@ namespace Flare {
             // bad names
             return false;
         }
-        nodeProps[in1].insert(prop);
+        sizeNodeAttrsi();
+        uint8_t bit = propBit(prop);
+        if (nodePropBits[in1] & bit) {
+            return true;
+        }
+        nodePropBits[in1] |= bit;
         if (prop == NodeProperty::Root) {
+            if (rootNode >= 0) {
+                nodePropBits[rootNode] &= ~ROOT_BIT;
+            }
             rootNode = in1;
+            touchRoots();
         } else if (prop == NodeProperty::Sentry) {
+            sentrySlots[in1] = (int)sentryNodes.size();
             sentryNodes.push_back(in1);
+            touchRoots();
         }
         return true;
     }
 
+    bool FlareGraph::hasNodeProp(int n1, NodeProperty prop) const {
+        int in1 = mapNode(n1);
+        if ((in1 < 0) || ((size_t)in1 >= nodePropBits.size())) {
+            return false;
+        }
+        return (nodePropBits[in1] & propBit(prop)) != 0;
+    }
+
     // Stores the current graph to a simplified graphviz dot format
     // Mostly just used for debugging/testing
     bool FlareGraph::storeGraphViz(std::ostream &os) {
         std::vector<std::string> nodes;
         std::vector<std::string> props;
-        for (int n1 = 0; (unsigned int)n1 < succs.size(); ++n1) {
+        for (int n1 = 0; n1 < getNodeCount(); ++n1) {
             for (int n2 = 0; n2 < nsucci(n1); ++n2) {
                 std::ostringstream currEdge;
                 currEdge << "    " << reverseMapNode(n1) << " -> " << reverseMapNode(succi(n1, n2)) << "\n";
                 nodes.push_back(currEdge.str());
             }
         }
-        for (nodepropiter_t nodeit = nodeProps.begin(); nodeit != nodeProps.end(); ++nodeit) {
-            for (propiter_t propit = nodeit->second.begin(); propit != nodeit->second.end(); ++propit) {
+        const NodeProperty allProps[] = { NodeProperty::Selected, NodeProperty::Pruned, NodeProperty::Root, NodeProperty::Sentry };
+        for (int n1 = 0; n1 < (int)nodePropBits.size(); ++n1) {
+            for (int p = 0; p < 4; ++p) {
+                if ((nodePropBits[n1] & propBit(allProps[p])) == 0) {
+                    continue;
+                }
                 std::ostringstream currProp;
-                currProp << "    " << reverseMapNode(nodeit->first) << " [ style=\"filled\" fillcolor=\"";
-                switch (*propit) {
+                currProp << "    " << reverseMapNode(n1) << " [ style=\"filled\" fillcolor=\"";
+                switch (allProps[p]) {
                 case NodeProperty::Selected:
                     currProp << NODE_COLOR_SELECTED;
                     break;
@@ -382,9 +1036,12 @@ namespace Flare {
             }
         }
         // now the raw node colors. not to be used concurrently with our overloaded node properties!
-        for (auto it = nodeColors.begin(); it != nodeColors.end(); ++it) {
+        for (int n1 = 0; n1 < (int)nodeColorIds.size(); ++n1) {
+            if (nodeColorIds[n1] == 0) {
+                continue;
+            }
             std::ostringstream currProp;
-            currProp << "    " << reverseMapNode(it->first) << " [ style=\"filled\" fillcolor=\"" << it->second << "\"]\n";
+            currProp << "    " << reverseMapNode(n1) << " [ style=\"filled\" fillcolor=\"" << colorNames[nodeColorIds[n1] - 1] << "\"]\n";
             props.push_back(currProp.str());
         }
 
@@ -421,6 +1078,12 @@ namespace Flare {
     bool FlareGraph::loadGraphViz(std::istream &in) {
         std::string line;
         int state = 0;
+        // nodes, edges and properties are collected first and added in bulk once
+        // the whole file has parsed
+        intvector_t names;
+        intvector_t sources;
+        intvector_t targets;
+        std::vector<std::pair<int, NodeProperty> > props;
         while (std::getline(in, line)) {
             //first look for end of line comments
             std::size_t pos = line.find("//");
@@ -459,9 +1122,10 @@ namespace Flare {
                         int n1 = atoi(strs[0].c_str());
                         int n2 = atoi(strs[2].c_str());
                         DEBUGLOG("add %d -> %d edge\n", n1, n2);
-                        addNode(n1);
-                        addNode(n2);
-                        addEdge(n1, n2);
+                        names.push_back(n1);
+                        names.push_back(n2);
+                        sources.push_back(n1);
+                        targets.push_back(n2);
                     }
                 } else if (line.find("[") != std::string::npos) {
                     DEBUGLOG("Node property\n");
@@ -470,16 +1134,16 @@ namespace Flare {
                     int n1 = atoi(strs[0].c_str());
                     if (line.find(NODE_COLOR_SELECTED) != std::string::npos) {
                         DEBUGLOG("node selected: %d\n", n1);
-                        addNodeProp(n1, NodeProperty::Selected);
+                        props.push_back(std::make_pair(n1, NodeProperty::Selected));
                     } else if (line.find(NODE_COLOR_PRUNED) != std::string::npos) {
                         DEBUGLOG("node pruned: %d\n", n1);
-                        addNodeProp(n1, NodeProperty::Pruned);
+                        props.push_back(std::make_pair(n1, NodeProperty::Pruned));
                     } else if (line.find(NODE_COLOR_ROOT) != std::string::npos) {
                         DEBUGLOG("node root: %d\n", n1);
-                        addNodeProp(n1, NodeProperty::Root);
+                        props.push_back(std::make_pair(n1, NodeProperty::Root));
                     } else if (line.find(NODE_COLOR_SENTRY) != std::string::npos) {
                         DEBUGLOG("node sentry: %d\n", n1);
-                        addNodeProp(n1, NodeProperty::Sentry);
+                        props.push_back(std::make_pair(n1, NodeProperty::Sentry));
                     } else {
                         DEBUGLOG("Unknown property line: '%s'\n", line.c_str());
                         return false;
@@ -493,99 +1157,158 @@ namespace Flare {
                 return false;
             }
         }
+        if (!addNodes(names) || !addEdges(sources, targets)) {
+            return false;
+        }
+        for (unsigned int i = 0; i < props.size(); ++i) {
+            addNodeProp(props[i].first, props[i].second);
+        }
         return true;
     }
 
     bool FlareGraph::uniqueReachable(intset_t &out) {
-        std::set<int>::iterator it;
-        intset_t reachableSet;
+        NodeSet reachableSet;
         bool ret = uniqueReachablei(reachableSet);
         if (!ret) {
             return false;
         }
-        for (it = reachableSet.begin(); it != reachableSet.end(); ++it) {
-            out.insert(reverseMapNode(*it));
-        }
+        reachableSet.forEach([&](int n) { out.insert(reverseMapNode(n)); });
         return true;
     }
 
-    // internal unique-reachable calculation. uses the current root node as the start.
-    bool FlareGraph::uniqueReachablei(intset_t &out) {
-
-        //1) Traverse graph, add each reachable node to the reachableSet vector.
-        //  if we encounger a node already in the reachable group, ignore it since it's already processed)
-        //  if we encounter a sentry node, ignore it & its children (already Processed)
-        //  process until stack is emtpy
-        //2) For every node in the reachableSet, check if it has any preds not in the graph, 
-        //  which would mean it is reachable out of the newGroup, remove the node (i.e. add 
-        //  to a toRemove vector),  do a traversal on its children, also adding them to the 
-        //  toRemove vector (if not already present).
-        //3) fill newGroup, which is all nodes in reachableSet that aren't in toRemove
-        intset_t reachableSet;
-        intset_t toPrune;
-        int anode;
-        bool ret = reachablei(reachableSet);
-        if (!ret) {
-            DEBUGLOG("reachablei failed\n");
+    // internal unique-reachable calculation. uses the current root node as the start
+    bool FlareGraph::uniqueReachablei(NodeSet &out) {
+        if (uniqueReachCache.valid(rootsGen)) {
+            out = uniqueReachCache.value;
+            return true;
+        }
+        if (rootNode < 0) {
+            LOG("No root node set\n");
             return false;
         }
-        DEBUGLOG("Beginning pruning of %d reachable nodes\n", reachableSet.size());
-        for (auto it = reachableSet.begin(); it != reachableSet.end(); ++it) {
-            anode = *it;
-            if (anode == rootNode) {
-                // rootNode will likely have non-reachable preds, but need to keep it
-                continue;
-            }
-            if (intsetHas(toPrune, anode)) {
-                // we've already pruned this node & all it's reachable children. just continue
-                continue;
+        uniqueReachableFromi(rootNode, uniqueReachCache.value);
+        uniqueReachCache.stamp = rootsGen;
+        out = uniqueReachCache.value;
+        return true;
+    }
+
+    // a reachable node is uniquely reachable when root dominates it in the graph
+    // cut at the sentries, with every node outside the reachable set acting as an
+    // extra entry. a node loses that as soon as some path from outside reaches it
+    // without going through root, so the nodes to drop are exactly those reached
+    // by one walk seeded from every reachable node (other than root) that has a
+    // predecessor outside the reachable set, never entering root.
+    void FlareGraph::uniqueReachableFromi(int root, NodeSet &out) {
+        NodeSet reachableSet;
+        if (root == rootNode) {
+            reachablei(reachableSet);
+        } else {
+            reachableFromi(root, reachableSet);
+        }
+        const FrozenGraph &fg = frozen();
+        // cut starts as everything outside the reachable set plus root, and the
+        // walk adds every node that can be reached around root
+        NodeSet cut(reachableSet);
+        cut.complement();
+        intvector_t seeds;
+        reachableSet.forEach([&](int anode) {
+            if (anode == root) {
+                // root will likely have non-reachable preds, but need to keep it
+                return;
             }
-            bool prune = false;
-            for (int j = 0; j < npredi(anode); ++j) {
-                int pred = predi(anode, j);
-                if (!intsetHas(reachableSet, pred)) {
-                    // not reachable, so we need to prune anode current node and 
-                    // all reachable children of anode
-                    prune = true;
+            for (const int *pit = fg.predBegin(anode); pit != fg.predEnd(anode); ++pit) {
+                if (cut.has(*pit)) {
+                    seeds.push_back(anode);
                     break;
-                } else {
-                    // nothing, we're good
                 }
             }
-            if (prune) {
-                // do a traversal starting at this node, adding this node and all reachable 
-                // children to the toPrune vector
-                intdeque_t pendingAnalysis;
-                pendingAnalysis.push_back(anode);
-                while (pendingAnalysis.size() > 0) {
-                    // pnode: node to prune
-                    int pnode = pendingAnalysis.back();
-                    pendingAnalysis.pop_back();
-                    if (!intsetHas(reachableSet, pnode)) {
-                        // the node isn't reachable... this shouldn't hit, right?
-                        continue;
-                    }
-                    if (!intsetHas(toPrune, pnode)) {
-                        // not already in toPrune, so add it
-                        toPrune.insert(pnode);
-                        // queue all children nodes for analysis
-                        for (int i = 0; i < nsucci(pnode); ++i) {
-                            int snode = succi(pnode, i);
-                            DEBUGLOG("pruning pendingAnalysis.has(snode) %d items\n", pendingAnalysis.size());
-                            if ((snode != rootNode) && (!intdequeHas(pendingAnalysis, snode))) {
-                                pendingAnalysis.push_back(snode);
-                            }
-                        }
-                    }
-                }
+        });
+        cut.insert(root);
+        walkSuccsi(seeds, cut, NULL);
+        cut.erase(root);
+        reachableSet.subtract(cut);
+        std::swap(out, reachableSet);
+    }
+
+    // unique-reachable sets for every successor of dispatcher, as if each had been
+    // made the root in turn.
+    //
+    // with a virtual entry feeding every node without predecessors and every sentry,
+    // a case c uniquely reaches exactly the nodes it dominates: any path around c
+    // starts at an entry, and every entry other than c lies outside what c reaches.
+    // nodes only reachable through entry-less cycles get a representative entry of
+    // their own. that representative could sit inside what c reaches, so cases in
+    // such cycles fall back to the single-root calculation
+    bool FlareGraph::uniqueReachableCases(int dispatcher, intsetMap_t &out) {
+        int in1 = mapNode(dispatcher);
+        if (in1 < 0) {
+            LOG("Unknown dispatcher node %d\n", dispatcher);
+            return false;
+        }
+        const FrozenGraph &fg = frozen();
+        int count = fg.nodeCount();
+        sizeNodeAttrsi();
+        intvector_t entries;
+        for (int n = 0; n < count; ++n) {
+            if ((nodePropBits[n] & SENTRY_BIT) || (fg.predBegin(n) == fg.predEnd(n))) {
+                entries.push_back(n);
+            }
+        }
+        NodeSet entered(count);
+        walkSuccsi(entries, entered, NULL);
+        NodeSet cyclic(entered);
+        cyclic.complement();
+        for (int n = 0; n < count; ++n) {
+            if (!entered.has(n)) {
+                entries.push_back(n);
+                walkSuccsi(n, entered, NULL);
+            }
+        }
+
+        intvector_t idom;
+        computeDominators(entries, false, idom);
+        // dominator tree children as CSR. the virtual root's children aren't needed
+        intvector_t childOffsets(count + 2, 0);
+        for (int n = 0; n < count; ++n) {
+            if ((idom[n] >= 0) && (idom[n] < count)) {
+                ++childOffsets[idom[n] + 2];
+            }
+        }
+        for (int n = 0; n <= count; ++n) {
+            childOffsets[n + 1] += childOffsets[n];
+        }
+        intvector_t children(childOffsets[count + 1]);
+        for (int n = 0; n < count; ++n) {
+            if ((idom[n] >= 0) && (idom[n] < count)) {
+                children[childOffsets[idom[n] + 1]++] = n;
             }
         }
-        // okay, now build the newGroup vector: reachableSet - toPrune
-        for (auto it = reachableSet.begin(); it != reachableSet.end(); ++it) {
-            anode = *it;
-            // if the node isn't in the toPrune set, add it to the output 
-            if (toPrune.find(anode) == toPrune.end()) {
-                out.insert(anode);
+
+        for (const int *sit = fg.succBegin(in1); sit != fg.succEnd(in1); ++sit) {
+            int caseNode = *sit;
+            int name = reverseMapNode(caseNode);
+            if (out.find(name) != out.end()) {
+                continue;
+            }
+            intset_t &group = out[name];
+            if (nodePropBits[caseNode] & SENTRY_BIT) {
+                // a sentry root reaches nothing
+                continue;
+            }
+            if (cyclic.has(caseNode)) {
+                DEBUGLOG("Case %d is only reachable through a cycle, doing it alone\n", name);
+                NodeSet caseSet;
+                uniqueReachableFromi(caseNode, caseSet);
+                caseSet.forEach([&](int n) { group.insert(reverseMapNode(n)); });
+                continue;
+            }
+            walkStack.clear();
+            walkStack.push_back(caseNode);
+            while (!walkStack.empty()) {
+                int anode = walkStack.back();
+                walkStack.pop_back();
+                group.insert(reverseMapNode(anode));
+                walkStack.insert(walkStack.end(), children.begin() + childOffsets[anode], children.begin() + childOffsets[anode + 1]);
             }
         }
         return true;
@@ -593,17 +1316,17 @@ namespace Flare {
 
     // public wrapper around reachablei()
     bool FlareGraph::reachable(intset_t &out) {
-        std::set<int>::iterator it;
-        intset_t reachableSet;
+        NodeSet reachableSet;
         bool ret = reachablei(reachableSet);
         if (!ret) {
             return false;
         }
-        for (it = reachableSet.begin(); it != reachableSet.end(); ++it) {
-            out.insert(reverseMapNode(*it));
-            DEBUGLOG("Adding reachable node %d\n", reverseMapNode(*it));
-        }
-        if (out.size() != reachableSet.size()) {
+        size_t before = out.size();
+        reachableSet.forEach([&](int n) {
+            out.insert(reverseMapNode(n));
+            DEBUGLOG("Adding reachable node %d\n", reverseMapNode(n));
+        });
+        if (out.size() - before != (size_t)reachableSet.size()) {
             LOG("Ruh roh: size mismatch %d vs %d\n", reachableSet.size(), out.size());
         }
         return true;
@@ -611,46 +1334,19 @@ namespace Flare {
 
 
     // internal reachable graph search. uses the current root node as the start
-    bool FlareGraph::reachablei(intset_t &reachableSet) {
-        intdeque_t pendingAnalysis;
+    bool FlareGraph::reachablei(NodeSet &reachableSet) {
         if (rootNode < 0) {
             LOG("No root node set\n");
             return false;
         }
-        int anode = -1;
-        int succ = -1;
-        pendingAnalysis.push_back(rootNode);
-        while (pendingAnalysis.size() > 0) {
-            anode = pendingAnalysis.back();
-            pendingAnalysis.pop_back();
-            DEBUGLOG("Now examining %d\n", reverseMapNode(anode));
-            if (intsetHas(reachableSet, anode)) {
-                // nothing
-                DEBUGLOG("Skipping already in reachableSet %d\n", reverseMapNode(anode));
-                continue;
-            } else {
-                DEBUGLOG("pendingAnalysis.has(anode) %d items\n", pendingAnalysis.size());
-                if (intdequeHas(pendingAnalysis, anode)) {
-                    // nothing
-                    DEBUGLOG("Skipping already in pendingAnalysis.has %d\n", reverseMapNode(anode));
-                    continue;
-                } else if (!intvectorHas(sentryNodes, anode)) {
-                    // only add if it's not a sentry node
-                    DEBUGLOG("Queueing reachable pendingAnalysis %d\n", reverseMapNode(anode));
-                    reachableSet.insert(anode);
-                    // push all children succcessors to the pendingAnalysis stack
-                    for (int i = 0; i < nsucci(anode); ++i) {
-                        succ = succi(anode, i);
-                        DEBUGLOG("pendingAnalysis.has(succ) %d items\n", pendingAnalysis.size());
-                        if (!intdequeHas(pendingAnalysis, succ)) {
-                            DEBUGLOG("Queueing %d -> %d\n", reverseMapNode(anode), reverseMapNode(succ));
-                            pendingAnalysis.push_back(succ);
-                        }
-                    }
-                }
-            }
+        if (reachCache.valid(rootsGen)) {
+            reachableSet = reachCache.value;
+            return true;
         }
+        reachableFromi(rootNode, reachableSet);
         DEBUGLOG("Root node: %d. Found %d reachable nodes\n", reverseMapNode(rootNode), reachableSet.size());
+        reachCache.value = reachableSet;
+        reachCache.stamp = rootsGen;
         if (reachableSet.size() == 0) {
             LOG("Ruh roh. Reachable is 0. That can't be right\n");
             return true;
@@ -658,57 +1354,485 @@ namespace Flare {
         return true;
     }
 
+    void FlareGraph::reachableFromi(int root, NodeSet &out) {
+        const FrozenGraph &fg = frozen();
+        out.reset(fg.nodeCount());
+        // sentry nodes are neither added nor followed
+        sizeNodeAttrsi();
+        walkStack.clear();
+        walkStack.push_back(root);
+        walk<SuccDir>(fg, walkStack, out, SkipProps(nodePropBits, SENTRY_BIT), NoVisit());
+    }
+
+    // semi-NCA (Georgiadis) dominator calculation:
+    //   1) iterative DFS from the roots, numbering nodes in preorder
+    //   2) semidominators in reverse preorder, using path-compressed eval over the
+    //      already processed part of the DFS tree
+    //   3) idom as the nearest common ancestor of the DFS parent and the semidominator
+    // everything below works on preorder numbers, with 0 being the (possibly virtual) root
+    void FlareGraph::computeDominators(const intvector_t &roots, bool post, intvector_t &outIdom) {
+        const FrozenGraph &fg = frozen();
+        int count = fg.nodeCount();
+        // forward edges are used for the DFS, backward edges to find semidominators
+        const intvector_t &bwdOffsets = post ? fg.succOffsets : fg.predOffsets;
+        const intvector_t &bwdTargets = post ? fg.succTargets : fg.predTargets;
+        bool virtualRoot = roots.size() > 1;
+
+        intvector_t pre(count, -1);
+        intvector_t vertex;
+        intvector_t parent;
+        vertex.reserve(count + 1);
+        parent.reserve(count + 1);
+        // roots reached by an earlier root's DFS still have the virtual root as a
+        // direct predecessor, so they are flagged to force their semidominator to 0
+        std::vector<bool> isRoot;
+        if (virtualRoot) {
+            vertex.push_back(count);
+            parent.push_back(0);
+            isRoot.assign(count, false);
+            for (unsigned int r = 0; r < roots.size(); ++r) {
+                isRoot[roots[r]] = true;
+            }
+        }
+
+        // 1) preorder DFS
+        NodeSet seen(count);
+        dfsStack_t dfsStack;
+        auto discover = [&](int n, int from) {
+            parent.push_back(from < 0 ? 0 : pre[from]);
+            pre[n] = (int)vertex.size();
+            vertex.push_back(n);
+        };
+        for (unsigned int r = 0; r < roots.size(); ++r) {
+            if (post) {
+                dfs<PredDir>(fg, roots[r], dfsStack, seen, AllNodes(), discover, NoVisit());
+            } else {
+                dfs<SuccDir>(fg, roots[r], dfsStack, seen, AllNodes(), discover, NoVisit());
+            }
+        }
+        int numbered = (int)vertex.size();
+
+        // 2) semidominators. a number is "linked" into the eval forest once it has been
+        // processed, which is the case for every number above w
+        intvector_t semi(numbered);
+        intvector_t label(numbered);
+        intvector_t ancestor(parent);
+        intvector_t compressStack;
+        for (int v = 0; v < numbered; ++v) {
+            semi[v] = v;
+            label[v] = v;
+        }
+        for (int w = numbered - 1; w > 0; --w) {
+            int sdom = parent[w];
+            int node = vertex[w];
+            // the virtual root has no in-edges in the CSR arrays, and is the
+            // semidominator of every root
+            if (virtualRoot && isRoot[node]) {
+                sdom = 0;
+            } else if (node != count) {
+                for (int e = bwdOffsets[node]; e < bwdOffsets[node + 1]; ++e) {
+                    int v = pre[bwdTargets[e]];
+                    if (v < 0) {
+                        // edge from a node we can't reach
+                        continue;
+                    }
+                    int u = v;
+                    if (v > w) {
+                        // eval(v): compress the path to the first unlinked ancestor, keeping
+                        // the label with the smallest semidominator
+                        compressStack.clear();
+                        int x = v;
+                        while (ancestor[x] > w) {
+                            compressStack.push_back(x);
+                            x = ancestor[x];
+                        }
+                        for (int k = (int)compressStack.size() - 1; k >= 0; --k) {
+                            int y = compressStack[k];
+                            int a = ancestor[y];
+                            if (semi[label[a]] < semi[label[y]]) {
+                                label[y] = label[a];
+                            }
+                            ancestor[y] = ancestor[a];
+                        }
+                        u = label[v];
+                    }
+                    if (semi[u] < sdom) {
+                        sdom = semi[u];
+                    }
+                }
+            }
+            semi[w] = sdom;
+        }
+
+        // 3) walk up the dominator tree of the parent until we're at or above the semidominator
+        intvector_t idomNum(numbered, 0);
+        for (int w = 1; w < numbered; ++w) {
+            int d = parent[w];
+            while (d > semi[w]) {
+                d = idomNum[d];
+            }
+            idomNum[w] = d;
+        }
+
+        outIdom.assign(count, -1);
+        for (int w = 1; w < numbered; ++w) {
+            int node = vertex[w];
+            if (node != count) {
+                outIdom[node] = vertex[idomNum[w]];
+            }
+        }
+        if (!virtualRoot) {
+            outIdom[vertex[0]] = -1;
+        }
+    }
+
+    bool FlareGraph::domTreei(int entry, bool post, intvector_t &outIdom) {
+        int in1 = mapNode(entry);
+        if (in1 < 0) {
+            // bad names
+            return false;
+        }
+        intvector_t roots(1, in1);
+        computeDominators(roots, post, outIdom);
+        return true;
+    }
+
     // public immediate-dominator tree calculation.
     bool FlareGraph::idom(intintMap_t &outdom, int entry) {
-        DEBUGLOG("Creating idom DomGraph with %d nodes\n", succs.size());
-        DomGraph dgr(succs.size());
-        for (int n1 = 0; (unsigned int)n1 < succs.size(); ++n1) {
-            for (int n2 = 0; n2 < nsucci(n1); ++n2) {
-                boost::add_edge(boost::vertex(n1, dgr), boost::vertex(succi(n1, n2), dgr), dgr);
-            }
+        intvector_t dom;
+        if (!domTreei(entry, false, dom)) {
+            return false;
         }
-        return idomHelper(dgr, outdom, entry);
+        DEBUGLOG("Creating idom %d items\n", dom.size());
+        for (int i = 0; i < (int)dom.size(); ++i) {
+            outdom[reverseMapNode(i)] = reverseMapNode(dom[i]);
+        }
+        return true;
     }
 
     // public immediate-post-dominator tree calculation.
     bool FlareGraph::ipdom(intintMap_t &outdom, int entry) {
-        DomGraph dgr(succs.size());
-        for (int n1 = 0; (unsigned int)n1 < succs.size(); ++n1) {
-            for (int n2 = 0; n2 < nsucci(n1); ++n2) {
-                //manually reverse the graph edges rather than boost's make_reverse
-                boost::add_edge(boost::vertex(succi(n1, n2), dgr), boost::vertex(n1, dgr), dgr);
+        intvector_t dom;
+        if (!domTreei(entry, true, dom)) {
+            return false;
+        }
+        DEBUGLOG("Creating ipdom %d items\n", dom.size());
+        for (int i = 0; i < (int)dom.size(); ++i) {
+            outdom[reverseMapNode(i)] = reverseMapNode(dom[i]);
+        }
+        return true;
+    }
+
+    // converts an idom array over internal names to one indexed by public name
+    void FlareGraph::publicDomVector(const intvector_t &dom, intvector_t &out) const {
+        if (structure->identityNames) {
+            out = dom;
+            return;
+        }
+        int maxName = -1;
+        for (int i = 0; i < (int)dom.size(); ++i) {
+            maxName = (std::max)(maxName, reverseMapNode(i));
+        }
+        out.assign(maxName + 1, -1);
+        for (int i = 0; i < (int)dom.size(); ++i) {
+            out[reverseMapNode(i)] = reverseMapNode(dom[i]);
+        }
+    }
+
+    bool FlareGraph::idom(intvector_t &out, int entry) {
+        intvector_t dom;
+        if (!domTreei(entry, false, dom)) {
+            return false;
+        }
+        publicDomVector(dom, out);
+        return true;
+    }
+
+    bool FlareGraph::ipdom(intvector_t &out, int entry) {
+        intvector_t dom;
+        if (!domTreei(entry, true, dom)) {
+            return false;
+        }
+        publicDomVector(dom, out);
+        return true;
+    }
+
+    const intvector_t &FlareGraph::terminalsi(bool post) {
+        CachedResult<intvector_t> &cache = terminalsCache[post ? 1 : 0];
+        if (cache.valid(structureGen)) {
+            return cache.value;
+        }
+        const FrozenGraph &fg = frozen();
+        int count = fg.nodeCount();
+        cache.value.clear();
+        for (int i = 0; i < count; ++i) {
+            if ((post ? fg.nsucc(i) : fg.npred(i)) == 0) {
+                DEBUGLOG("Found term node: %d\n", reverseMapNode(i));
+                cache.value.push_back(i);
             }
         }
-        return idomHelper(dgr, outdom, entry);
+
+        // a function that never returns (or is only a loop) has no such node, so
+        // nothing in it would ever get a post-dominator (or dominator). then every
+        // sink (source) component of the SCC condensation gets a stand-in: the node
+        // deepest in the DFS for exits, the lowest name for entries (which is also
+        // where rpoi() starts the DFS into it). with real terminals the closed loops
+        // are left alone, so they don't change the regions around the real exits
+        if (!cache.value.empty()) {
+            cache.stamp = structureGen;
+            return cache.value;
+        }
+        const intvector_t &comp = scci();
+        int components = 0;
+        for (int i = 0; i < count; ++i) {
+            components = (std::max)(components, comp[i] + 1);
+        }
+        intvector_t pick(components, -1);
+        for (int i = 0; i < count; ++i) {
+            const int *it = post ? fg.succBegin(i) : fg.predBegin(i);
+            const int *end = post ? fg.succEnd(i) : fg.predEnd(i);
+            for (; it != end; ++it) {
+                if (comp[*it] != comp[i]) {
+                    // the component is left (entered) through this edge
+                    pick[comp[i]] = -2;
+                    break;
+                }
+            }
+        }
+        if (post) {
+            const intvector_t &rpoNum = rpoNumberi();
+            for (int i = 0; i < count; ++i) {
+                int &p = pick[comp[i]];
+                if ((p == -1) || ((p >= 0) && (rpoNum[i] > rpoNum[p]))) {
+                    p = i;
+                }
+            }
+        } else {
+            for (int i = 0; i < count; ++i) {
+                if (pick[comp[i]] == -1) {
+                    pick[comp[i]] = i;
+                }
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            if (pick[comp[i]] == i) {
+                DEBUGLOG("Using %d as the %s of a closed loop\n", reverseMapNode(i), post ? "exit" : "entry");
+                cache.value.push_back(i);
+            }
+        }
+        cache.stamp = structureGen;
+        return cache.value;
     }
 
-    // actual implementation for the immediate-dominator calculation.
-    // entry is the external name of the node to start the search at
-    bool FlareGraph::idomHelper(DomGraph &dgr, intintMap_t &outdom, int entry) {
-        int in1 = mapNode(entry);
-        if (in1 < 0) {
-            // bad names
+    // with a virtual root, a node's idom is a real node d exactly when every path
+    // between the node and any of the roots passes through d, which is also when
+    // every per-root tree that reaches the node agrees on d. a non-root node whose
+    // idom is the virtual root reaches several roots that disagree, which
+    // is what the per-root merge calls IPDOM_CONFLICT
+    const intvector_t &FlareGraph::mergedDomTreei(bool post) {
+        CachedResult<intvector_t> &cache = domTreeCache[post ? 1 : 0];
+        if (cache.valid(structureGen)) {
+            return cache.value;
+        }
+        const intvector_t &roots = terminalsi(post);
+        intvector_t &dom = cache.value;
+        computeDominators(roots, post, dom);
+        if (roots.size() > 1) {
+            int count = (int)dom.size();
+            for (unsigned int r = 0; r < roots.size(); ++r) {
+                dom[roots[r]] = IPDOM_UNKNOWN;
+            }
+            for (int i = 0; i < count; ++i) {
+                if (dom[i] == count) {
+                    dom[i] = IPDOM_CONFLICT;
+                }
+            }
+        }
+        cache.stamp = structureGen;
+        return dom;
+    }
+
+    const DominanceIndex &FlareGraph::dominanceIndexi(bool post) {
+        CachedResult<DominanceIndex> &cache = domIndexCache[post ? 1 : 0];
+        if (cache.valid(structureGen)) {
+            return cache.value;
+        }
+        int count = frozen().nodeCount();
+        const intvector_t &roots = terminalsi(post);
+        DominanceIndex &index = cache.value;
+        intvector_t &parent = index.parent;
+        // a single root has no virtual root in computeDominators(), so hang it off one here
+        computeDominators(roots, post, parent);
+        parent.push_back(-1);
+        if (roots.size() == 1) {
+            parent[roots[0]] = count;
+        }
+
+        intvector_t childOffsets(count + 2, 0);
+        for (int i = 0; i < count; ++i) {
+            if (parent[i] >= 0) {
+                ++childOffsets[parent[i] + 1];
+            }
+        }
+        for (int i = 0; i <= count; ++i) {
+            childOffsets[i + 1] += childOffsets[i];
+        }
+        intvector_t children(childOffsets[count + 1]);
+        intvector_t fill(childOffsets.begin(), childOffsets.end() - 1);
+        for (int i = 0; i < count; ++i) {
+            if (parent[i] >= 0) {
+                children[fill[parent[i]]++] = i;
+            }
+        }
+
+        intvector_t &order = index.order;
+        intvector_t &pre = index.pre;
+        intvector_t &depth = index.depth;
+        pre.assign(count + 1, -1);
+        depth.assign(count + 1, 0);
+        order.clear();
+        order.reserve(count + 1);
+        std::vector<intintPair_t> dfsStack;
+        pre[count] = 0;
+        order.push_back(count);
+        dfsStack.push_back(std::make_pair(count, childOffsets[count]));
+        while (!dfsStack.empty()) {
+            intintPair_t &top = dfsStack.back();
+            if (top.second == childOffsets[top.first + 1]) {
+                dfsStack.pop_back();
+                continue;
+            }
+            int next = children[top.second++];
+            depth[next] = depth[top.first] + 1;
+            pre[next] = (int)order.size();
+            order.push_back(next);
+            dfsStack.push_back(std::make_pair(next, childOffsets[next]));
+        }
+        // subtree sizes, accumulated bottom-up, turned into interval ends
+        intvector_t &last = index.last;
+        last.assign(count + 1, 1);
+        for (int k = (int)order.size() - 1; k > 0; --k) {
+            last[parent[order[k]]] += last[order[k]];
+        }
+        for (int i = 0; i <= count; ++i) {
+            last[i] = (pre[i] < 0) ? -1 : pre[i] + last[i];
+        }
+        cache.stamp = structureGen;
+        return index;
+    }
+
+    bool FlareGraph::dominates(int a, int b, bool post) {
+        int ia = mapNode(a);
+        int ib = mapNode(b);
+        if ((ia < 0) || (ib < 0)) {
             return false;
         }
-        boost::graph_traits<DomGraph>::vertex_iterator uItr, uEnd;
-        VertexVertexMap dominatorTree;
-        boost::associative_property_map<VertexVertexMap> domTreePredMap(dominatorTree);
-        lengauer_tarjan_dominator_tree(dgr, boost::vertex(in1, dgr), domTreePredMap);
+        return dominanceIndexi(post).dominates(ia, ib);
+    }
 
-        DEBUGLOG("Creating idom %d items\n", boost::num_vertices(dgr));
+    int FlareGraph::dominatedCount(int a, bool post) {
+        int ia = mapNode(a);
+        if (ia < 0) {
+            return 0;
+        }
+        return dominanceIndexi(post).subtreeSize(ia);
+    }
 
-        for (boost::tie(uItr, uEnd) = boost::vertices(dgr); uItr != uEnd; ++uItr) {
-            int n1 = reverseMapNode((int)(*uItr));
-            if (dominatorTree.find(*uItr) == dominatorTree.end()) {
-                DEBUGLOG("Adding res[%d] = null\n", n1);
-                //outdom[reverseMapNode(*uItr)] = (std::numeric_limits<int>::max)();
-                outdom[reverseMapNode((int)(*uItr))] = -1;
-            } else {
-                int n2 = reverseMapNode((int)(dominatorTree[(int)(*uItr)]));
-                DEBUGLOG("Adding res[%d] = %d\n", n1, n2);
-                outdom[n1] = n2;
+    const LcaTable &FlareGraph::lcaTablei(bool post) {
+        CachedResult<LcaTable> &cache = lcaCache[post ? 1 : 0];
+        if (cache.valid(structureGen)) {
+            return cache.value;
+        }
+        const DominanceIndex &dom = dominanceIndexi(post);
+        int n = (int)dom.order.size();
+        LcaTable &table = cache.value;
+        table.floorLog.assign(n + 1, 0);
+        for (int i = 2; i <= n; ++i) {
+            table.floorLog[i] = table.floorLog[i >> 1] + 1;
+        }
+        int levelCount = table.floorLog[n] + 1;
+        intvector_t &levels = table.levels;
+        levels.resize((size_t)levelCount * n);
+        for (int i = 0; i < n; ++i) {
+            levels[i] = i;
+        }
+        for (int j = 1; j < levelCount; ++j) {
+            const int *below = &levels[(size_t)(j - 1) * n];
+            int *level = &levels[(size_t)j * n];
+            int half = 1 << (j - 1);
+            for (int i = 0; i + 2 * half <= n; ++i) {
+                int a = below[i];
+                int b = below[i + half];
+                level[i] = (dom.depth[dom.order[a]] <= dom.depth[dom.order[b]]) ? a : b;
             }
         }
+        cache.stamp = structureGen;
+        return table;
+    }
+
+    int FlareGraph::lcai(int u, int v, bool post) {
+        const DominanceIndex &dom = dominanceIndexi(post);
+        if (!dom.reached(u) || !dom.reached(v)) {
+            return -1;
+        }
+        if (u == v) {
+            return u;
+        }
+        const LcaTable &table = lcaTablei(post);
+        int a = (std::min)(dom.pre[u], dom.pre[v]);
+        int b = (std::max)(dom.pre[u], dom.pre[v]);
+        // (a, b] lies inside the lca's subtree and holds the child on the way to b
+        size_t n = dom.order.size();
+        int j = table.floorLog[b - a];
+        int x = table.levels[j * n + a + 1];
+        int y = table.levels[j * n + b - (1 << j) + 1];
+        int pos = (dom.depth[dom.order[x]] <= dom.depth[dom.order[y]]) ? x : y;
+        return dom.parent[dom.order[pos]];
+    }
+
+    const intvector_t &FlareGraph::rpoi() {
+        if (rpoCache.valid(structureGen)) {
+            return rpoCache.value;
+        }
+        const FrozenGraph &fg = frozen();
+        int count = fg.nodeCount();
+        intvector_t &order = rpoCache.value;
+        order.clear();
+        order.reserve(count);
+        NodeSet seen(count);
+        dfsStack_t dfsStack;
+        const intvector_t &entries = terminalsi(false);
+        auto finish = [&order](int n) { order.push_back(n); };
+        // entries first, then every node in name order for the cycles they don't reach
+        for (int k = 0; k < (int)entries.size() + count; ++k) {
+            int start = k < (int)entries.size() ? entries[k] : k - (int)entries.size();
+            dfs<SuccDir>(fg, start, dfsStack, seen, AllNodes(), NoVisit(), finish);
+        }
+        // postorder -> reverse postorder
+        std::reverse(order.begin(), order.end());
+        rpoCache.stamp = structureGen;
+        return order;
+    }
+
+    const intvector_t &FlareGraph::rpoNumberi() {
+        if (rpoNumberCache.valid(structureGen)) {
+            return rpoNumberCache.value;
+        }
+        const intvector_t &order = rpoi();
+        rpoNumberCache.value.assign(order.size(), -1);
+        for (int i = 0; i < (int)order.size(); ++i) {
+            rpoNumberCache.value[order[i]] = i;
+        }
+        rpoNumberCache.stamp = structureGen;
+        return rpoNumberCache.value;
+    }
+
+    bool FlareGraph::rpo(intvector_t &out) {
+        const intvector_t &order = rpoi();
+        out.resize(order.size());
+        for (int i = 0; i < (int)order.size(); ++i) {
+            out[i] = reverseMapNode(order[i]);
+        }
         return true;
     }
 
@@ -720,26 +1844,21 @@ namespace Flare {
     bool FlareGraph::getDomIntMap(intintMap_t &out, bool doipdom) {
         //first thing: look for terminal nodes to do ipdom analysis from
         bool ret;
-        intvector_t terms;
-        for (unsigned int i = 0; i < succs.size(); ++i) {
-            if (doipdom) {
-                if (nsucci(i) == 0) {
-                    DEBUGLOG("Found term node: %d\n", reverseMapNode(i));
-                    terms.push_back(i);
-                }
-            } else {
-                if (npredi(i) == 0) {
-                    DEBUGLOG("Found term node: %d\n", reverseMapNode(i));
-                    terms.push_back(i);
-                }
-            }
-        }
+        const intvector_t &terms = terminalsi(doipdom);
         if (terms.size() == 0) {
-            // TODO: is there something we can do here? choose deepest node in a dfs traversal?
-            LOG("No terminal nodes. Likely an infinite function. Sorry - not yet implemented\n");
+            // closed loops get a stand-in terminal, so this only happens on an empty graph
+            LOG("No terminal nodes. Empty graph\n");
             return false;
         }
         DEBUGLOG("Found %d terminal nodes to examine\n", terms.size());
+        if (domMode == DomMode::VirtualRoot) {
+            // one pass from a virtual exit (or entry) instead of one per terminal
+            const intvector_t &dom = mergedDomTreei(doipdom);
+            for (int i = 0; i < (int)dom.size(); ++i) {
+                out[reverseMapNode(i)] = dom[i] < 0 ? dom[i] : reverseMapNode(dom[i]);
+            }
+            return true;
+        }
         int count = 0;
         // loop over each entry/terminal in terms to calculate the idom/ipdom tree
         //  then check for inconsistencies between runs. Throw out the inconsistencies.
@@ -833,16 +1952,10 @@ namespace Flare {
             return false;
         }
         //first thing: look for terminal nodes to do ipdom analysis from
-        intvector_t terms;
-        for (unsigned int i = 0; i < succs.size(); ++i) {
-            if (nsucci(i) == 0) {
-                DEBUGLOG("Found term node: %d\n", reverseMapNode(i));
-                terms.push_back(i);
-            }
-        }
+        const FrozenGraph &fg = frozen();
+        const intvector_t &terms = terminalsi(true);
         if (terms.size() == 0) {
-            // TODO: choose deepest node in a dfs traversal?
-            LOG("No terminal nodes. Likely an infinite function. Sorry - not yet implemented\n");
+            LOG("No terminal nodes. Empty graph\n");
             return false;
         }
         // remember that goodTerm is external name
@@ -850,77 +1963,75 @@ namespace Flare {
         // remember that goodipdom is external name
         int goodipdom = -1;
         DEBUGLOG("Found %d terminal nodes to examine\n", terms.size());
-        for (unsigned int i = 0; i < terms.size(); ++i) {
-            intintMap_t curripdom;
-            int extterm = reverseMapNode(terms[i]);
-            //remember that curripdom will have external names after ipdom() completes
-            DEBUGLOG("%d running ipdom: %d\n", i, extterm);
-            bool ret = ipdom(curripdom, extterm);
-            if (!ret) {
-                DEBUGLOG("ipdom failed for node %d\n", extterm);
-                continue;
+        if (domMode == DomMode::VirtualRoot) {
+            const intvector_t &pdom = mergedDomTreei(true);
+            if (pdom[in1] < 0) {
+                LOG("No immediate post-dominator shared by all terminals reachable from %d\n", entry);
+                return false;
             }
+            goodipdom = reverseMapNode(pdom[in1]);
+        } else {
+            for (unsigned int i = 0; i < terms.size(); ++i) {
+                intintMap_t curripdom;
+                int extterm = reverseMapNode(terms[i]);
+                //remember that curripdom will have external names after ipdom() completes
+                DEBUGLOG("%d running ipdom: %d\n", i, extterm);
+                bool ret = ipdom(curripdom, extterm);
+                if (!ret) {
+                    DEBUGLOG("ipdom failed for node %d\n", extterm);
+                    continue;
+                }
 
-            if (goodipdom < 0) {
-                goodipdom = curripdom[entry];
-                goodTerm = extterm;
-                DEBUGLOG("Setting initial goodipdom: %d %d\n", goodipdom, goodTerm);
-            } else {
-                if (goodipdom == curripdom[entry]) {
-                    // looking good. confirmation among different terminators
-                    DEBUGLOG("Match goodipdom: node[%d] = %d\n", goodTerm, goodipdom);
+                if (goodipdom < 0) {
+                    goodipdom = curripdom[entry];
+                    goodTerm = extterm;
+                    DEBUGLOG("Setting initial goodipdom: %d %d\n", goodipdom, goodTerm);
                 } else {
-                    LOG("Mismatch immediate dominators for different terminators: term[%d] = %d. term[%d] %d\n", 
-                            goodTerm, goodipdom, extterm, curripdom[entry]
-                    );
-                    return false;
+                    if (goodipdom == curripdom[entry]) {
+                        // looking good. confirmation among different terminators
+                        DEBUGLOG("Match goodipdom: node[%d] = %d\n", goodTerm, goodipdom);
+                    } else {
+                        LOG("Mismatch immediate dominators for different terminators: term[%d] = %d. term[%d] %d\n", 
+                                goodTerm, goodipdom, extterm, curripdom[entry]
+                        );
+                        return false;
+                    }
                 }
             }
         }
-        if ((goodTerm < 0) || (goodipdom < 0)) {
+        if (goodipdom < 0) {
             LOG("Failed to find good terminator to perform post-dominator analysis. :(\n");
             return false;
         }
         DEBUGLOG("Found the good %d. ipdom[%d] = %d\n", goodTerm, entry, goodipdom);
         // now we can just do a traversal starting at entry, stopping at goodipdom (inclusive) to create the set of nodes to join
-        intdeque_t pendingAnalysis;
-        //queue the entry point node we're trying to collapse
-        pendingAnalysis.push_back(in1);
-
+        NodeSet groupSet(fg.nodeCount());
         //add the good ipdom so we don't follow its successors in the traversal
-        outset.insert(goodipdom);
-
-        while (pendingAnalysis.size() > 0) {
-            DEBUGLOG("Current queue len: %d\n", pendingAnalysis.size());
-            int pnode = pendingAnalysis.back();
-            pendingAnalysis.pop_back();
-            int opnode = reverseMapNode(pnode);
-            DEBUGLOG("Got pending analysis node ext %d (int %d)\n", opnode, pnode);
-            if (intsetHas(outset, opnode)) {
-                // already in the output set, don't follow successors
-                DEBUGLOG("outset already has opnode %d\n", opnode);
-                continue;
-            }
-            // add to output
-            outset.insert(opnode);
-            // queue all children nodes for analysis
-            for (int k = 0; k < nsucci(pnode); ++k) {
-                int snode = succi(pnode, k);
-                int osnode = reverseMapNode(snode);
-                if ((!intsetHas(outset, osnode) && (!intdequeHas(pendingAnalysis, snode)))) {
-                    DEBUGLOG("Queueing successor ext %d (int %d)\n", osnode, snode);
-                    pendingAnalysis.push_back(snode);
-                }
-            }
-        }
+        groupSet.insert(mapNode(goodipdom));
+        //traverse from the entry point node we're trying to collapse
+        walkSuccsi(in1, groupSet, NULL);
+        groupSet.forEach([&](int n) { outset.insert(reverseMapNode(n)); });
         return true;
     }
 
     // top-level function to find isolated subgraphs of the current graph with
     // the given min/max parameters.
     bool FlareGraph::findSimpleSubGraphs(subgraphVec_t &out, unsigned int minNodeCount, unsigned int maxNodePercentage) {
+        return findSimpleSubGraphs(out, minNodeCount, maxNodePercentage, workspace);
+    }
+
+    bool FlareGraph::findSimpleSubGraphs(subgraphVec_t &out, unsigned int minNodeCount, unsigned int maxNodePercentage, AnalysisWorkspace &ws) {
+        AnalysisWorkspace::Scope scope(ws);
+        if (domMode == DomMode::VirtualRoot) {
+            // pair up n1/n2 straight from the two single-pass trees
+            if ((terminalsi(true).size() == 0) || (terminalsi(false).size() == 0)) {
+                LOG("No terminal or entry nodes. Empty graph\n");
+                return false;
+            }
+            return findSimpleRegions(out, minNodeCount, maxNodePercentage, ws);
+        }
+
         intintMap_t ipdomMap;
-        intintPairSet_t candidates;
         bool ret = getDomIntMap(ipdomMap, true);
         if (!ret) {
             LOG("Failed get ipdom map\n");
@@ -945,6 +2056,9 @@ namespace Flare {
             }
         });
 
+        // ipdomMap is ordered by n1, so the candidates come out sorted and unique
+        arenaIntintPairVec_t candidates((ArenaAllocator<intintPair_t>(ws)));
+        candidates.reserve(ipdomMap.size());
         for (auto pit = ipdomMap.begin(); pit != ipdomMap.end(); ++pit) {
             auto dit = idomMap.find(pit->second);
             if (dit == idomMap.end()) {
@@ -953,29 +2067,843 @@ namespace Flare {
             }
             if ((dit->second == pit->first) && (dit->first == pit->second)) {
                 DEBUGLOG("Matching idom/ipdom  nodes %d <=> %d\n", pit->first, dit->first);
-                candidates.insert(std::make_pair(pit->first, dit->first));
+                candidates.push_back(std::make_pair(pit->first, dit->first));
+            }
+        }
+        return verifySimpleSubGraphs(out, candidates, minNodeCount, maxNodePercentage, ws);
+    }
+
+    // finds the same subgraphs as verifySimpleSubGraphs() does for the candidates
+    // of findSimpleSubGraphs(), without walking each candidate separately.
+    // candidates are n2 with idom(n2) = n1 and ipdom(n1) = n2. because n1
+    // dominates n2, the walk in isSimpleSubGraph() covers at least
+    //   S = sub(n1) - sub(n2) + {n2}
+    // where sub() is a subtree of the (virtual-entry) dominator tree, and it covers
+    // exactly S unless an edge leaves S - {n2} for a node n1 doesn't dominate.
+    // that node would have a predecessor outside n1's subtree, so the region is
+    // only good if S - {n1} has no predecessors from outside S and S - {n2} has no
+    // such escaping edges and no terminals. with subtrees as preorder intervals,
+    // all of these come down to counts that are computed once for the whole tree:
+    //   terms/tainted: prefix sums of terminals and of nodes with an unreachable pred
+    //   escape[a]:     edges u->y that leave sub(a) from inside it. y's idom
+    //                  dominates u, so the edge leaves every ancestor of u below
+    //                  L = y (back edge) or L = idom(y) (anything else)
+    //   cross[c]:      edges from sub(c) that leave it just below L = idom(c)
+    //   crossBad[c]:   the subset of cross[c] that doesn't go back to idom(c) and
+    //                  doesn't start at c itself
+    //   backTo[y]:     edges into y from the rest of its subtree
+    // and the edges leaving S - {n2} are escape[n1] - escape[n2] + cross[n2]
+    void FlareGraph::scanSimpleRegions(arenaIntvector_t &exits, unsigned int minNodeCount, unsigned int maxNodePercentage, AnalysisWorkspace &ws) {
+        const FrozenGraph &fg = frozen();
+        int count = fg.nodeCount();
+        const intvector_t &pdom = mergedDomTreei(true);
+        const DominanceIndex &dom = dominanceIndexi(false);
+        const intvector_t &parent = dom.parent;
+        const intvector_t &order = dom.order;
+        const intvector_t &pre = dom.pre;
+        const intvector_t &depth = dom.depth;
+        int numbered = (int)order.size();
+        ArenaAllocator<int> alloc(ws);
+        arenaIntvector_t escape(count + 1, 0, alloc);
+        arenaIntvector_t cross(count + 1, 0, alloc);
+        arenaIntvector_t crossBad(count + 1, 0, alloc);
+        arenaIntvector_t backTo(count + 1, 0, alloc);
+        // per-edge counts. path holds the tree path from the virtual root to the
+        // current node as the preorder is replayed, so the child of L towards u is
+        // path[depth[L] + 1]
+        arenaIntvector_t termPrefix(numbered + 1, 0, alloc);
+        arenaIntvector_t taintPrefix(numbered + 1, 0, alloc);
+        arenaIntvector_t path(numbered + 1, 0, alloc);
+        for (int k = 1; k < numbered; ++k) {
+            int u = order[k];
+            path[depth[u]] = u;
+            bool tainted = false;
+            for (const int *pit = fg.predBegin(u); pit != fg.predEnd(u); ++pit) {
+                if (pre[*pit] < 0) {
+                    tainted = true;
+                }
+            }
+            termPrefix[k + 1] = termPrefix[k] + (fg.nsucc(u) == 0 ? 1 : 0);
+            taintPrefix[k + 1] = taintPrefix[k] + (tainted ? 1 : 0);
+            for (const int *sit = fg.succBegin(u); sit != fg.succEnd(u); ++sit) {
+                int y = *sit;
+                int low = dom.dominates(y, u) ? y : parent[y];
+                if (low == u) {
+                    // self loop
+                    continue;
+                }
+                if (low == y) {
+                    ++backTo[y];
+                }
+                ++escape[u];
+                --escape[low];
+                int c = path[depth[low] + 1];
+                ++cross[c];
+                if ((y != low) && (u != c)) {
+                    ++crossBad[c];
+                }
+            }
+        }
+        for (int k = numbered - 1; k > 0; --k) {
+            escape[parent[order[k]]] += escape[order[k]];
+        }
+        auto subCount = [&](const arenaIntvector_t &prefix, int a) { return prefix[dom.last[a]] - prefix[pre[a]]; };
+        auto nodeCount = [&](const arenaIntvector_t &prefix, int a) { return prefix[pre[a] + 1] - prefix[pre[a]]; };
+
+        exits.clear();
+        exits.reserve(numbered);
+        for (int k = 1; k < numbered; ++k) {
+            int in2 = order[k];
+            int in1 = parent[in2];
+            if ((in1 == count) || (pdom[in1] != in2)) {
+                continue;
+            }
+            if (subCount(termPrefix, in1) != subCount(termPrefix, in2)) {
+                DEBUGLOG("Found unexpected terminal during %d %d verification\n", reverseMapNode(in1), reverseMapNode(in2));
+                continue;
+            }
+            unsigned int size = dom.subtreeSize(in1) - dom.subtreeSize(in2) + 1;
+            if (size < minNodeCount) {
+                DEBUGLOG("Subgraph too small <%d,%d>: %d nodes > %d\n", reverseMapNode(in1), reverseMapNode(in2), size, minNodeCount);
+                continue;
+            }
+            unsigned int coverPercentInt = (unsigned int)(double(size)/count*100.0);
+            if (coverPercentInt > maxNodePercentage) {
+                DEBUGLOG("Subgraph too big <%d,%d>: %d nodes. %d percent > %d\n", reverseMapNode(in1), reverseMapNode(in2), size, coverPercentInt, maxNodePercentage);
+                continue;
+            }
+            int taints = subCount(taintPrefix, in1) - subCount(taintPrefix, in2) - nodeCount(taintPrefix, in1) + nodeCount(taintPrefix, in2);
+            int escapes = escape[in1] - escape[in2] + cross[in2];
+            if ((taints != 0) || (escapes != 0) || (crossBad[in2] != 0) || (backTo[in2] != 0)) {
+                DEBUGLOG("Subgraph has invalid predecessor or exit <%d,%d>\n", reverseMapNode(in1), reverseMapNode(in2));
+                continue;
+            }
+            exits.push_back(in2);
+        }
+    }
+
+    bool FlareGraph::findSimpleRegions(subgraphVec_t &out, unsigned int minNodeCount, unsigned int maxNodePercentage, AnalysisWorkspace &ws) {
+        arenaIntvector_t exits((ArenaAllocator<int>(ws)));
+        scanSimpleRegions(exits, minNodeCount, maxNodePercentage, ws);
+        const DominanceIndex &dom = dominanceIndexi(false);
+        const intvector_t &order = dom.order;
+        const intvector_t &pre = dom.pre;
+        // same order as the candidates used by verifySimpleSubGraphs()
+        arenaIntintPairVec_t regions((ArenaAllocator<intintPair_t>(ws)));
+        regions.reserve(exits.size());
+        for (auto it = exits.begin(); it != exits.end(); ++it) {
+            regions.push_back(std::make_pair(reverseMapNode(dom.parent[*it]), reverseMapNode(*it)));
+        }
+        std::sort(regions.begin(), regions.end());
+        out.reserve(out.size() + regions.size());
+        for (auto it = regions.begin(); it != regions.end(); ++it) {
+            int in1 = mapNode(it->first);
+            int in2 = mapNode(it->second);
+            out.push_back(subgraph_t(it->first, it->second));
+            intset_t &nodes = out.back().nodes;
+            for (int k = pre[in1]; k < dom.last[in1]; ++k) {
+                if ((k < pre[in2]) || (k >= dom.last[in2])) {
+                    nodes.insert(reverseMapNode(order[k]));
+                }
+            }
+            nodes.insert(it->second);
+            DEBUGLOG("Found simple graph <%d,%d>: %d nodes\n", it->first, it->second, nodes.size());
+        }
+        return true;
+    }
+
+    const FlareGraph::EnclosingScan &FlareGraph::enclosingScani(unsigned int minNodeCount, unsigned int maxNodePercentage) {
+        EnclosingScan &scan = enclosingCache.value;
+        if (enclosingCache.valid(structureGen) && (scan.minNodeCount == minNodeCount) && (scan.maxNodePercentage == maxNodePercentage)) {
+            return scan;
+        }
+        int count = frozen().nodeCount();
+        AnalysisWorkspace::Scope scope(workspace);
+        arenaIntvector_t exits((ArenaAllocator<int>(workspace)));
+        scanSimpleRegions(exits, minNodeCount, maxNodePercentage, workspace);
+        const DominanceIndex &dom = dominanceIndexi(false);
+        scan.minNodeCount = minNodeCount;
+        scan.maxNodePercentage = maxNodePercentage;
+        scan.exitOf.assign(count + 1, -1);
+        for (auto it = exits.begin(); it != exits.end(); ++it) {
+            scan.exitOf[dom.parent[*it]] = *it;
+        }
+        // top-down: the parent's region holds v unless v is its exit, in which case
+        // v is in the same regions its parent is in
+        scan.up.assign(count + 1, -1);
+        for (size_t k = 1; k < dom.order.size(); ++k) {
+            int v = dom.order[k];
+            int p = dom.parent[v];
+            if ((scan.exitOf[p] >= 0) && (scan.exitOf[p] != v)) {
+                scan.up[v] = p;
+            } else {
+                scan.up[v] = scan.up[p];
+            }
+        }
+        enclosingCache.stamp = structureGen;
+        return scan;
+    }
+
+    // a region <n1,n2> holding all of nodes needs n1 to dominate their common
+    // dominator d, and n2 to post-dominate their common post-dominator. with n1
+    // above d, the region holds d's whole subtree unless n2 lies on the way down
+    // to d, so the only candidates are:
+    //   n1 = d, if no node is below n2
+    //   n1 = idom(d), if nodes is just d and d is that region's exit
+    //   n1 = up[d], the closest entry above d whose exit isn't on the way to d
+    // everything above up[d] only holds larger regions
+    bool FlareGraph::findEnclosingRegion(const intset_t &nodes, subgraph_t &out, unsigned int minNodeCount, unsigned int maxNodePercentage) {
+        if (nodes.empty()) {
+            return false;
+        }
+        if ((terminalsi(true).size() == 0) || (terminalsi(false).size() == 0)) {
+            LOG("No terminal or entry nodes. Empty graph\n");
+            return false;
+        }
+        const DominanceIndex &dom = dominanceIndexi(false);
+        const DominanceIndex &pdom = dominanceIndexi(true);
+        intvector_t inodes;
+        inodes.reserve(nodes.size());
+        int first = -1;
+        int last = -1;
+        int pfirst = -1;
+        int plast = -1;
+        for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+            int in = mapNode(*it);
+            if ((in < 0) || !dom.reached(in) || !pdom.reached(in)) {
+                LOG("Node %d isn't part of the graph's dominator trees\n", *it);
+                return false;
+            }
+            inodes.push_back(in);
+            if ((first < 0) || (dom.pre[in] < dom.pre[first])) {
+                first = in;
+            }
+            if ((last < 0) || (dom.pre[in] > dom.pre[last])) {
+                last = in;
+            }
+            if ((pfirst < 0) || (pdom.pre[in] < pdom.pre[pfirst])) {
+                pfirst = in;
+            }
+            if ((plast < 0) || (pdom.pre[in] > pdom.pre[plast])) {
+                plast = in;
+            }
+        }
+        // the lca of a set is the lca of its first and last node in preorder
+        int count = getNodeCount();
+        int d = lcai(first, last, false);
+        int p = lcai(pfirst, plast, true);
+        if ((d == count) || (p == count)) {
+            DEBUGLOG("Nodes don't share a dominator and post-dominator\n");
+            return false;
+        }
+
+        const EnclosingScan &scan = enclosingScani(minNodeCount, maxNodePercentage);
+        int best = -1;
+        int bestSize = 0;
+        auto consider = [&](int n1) {
+            int n2 = scan.exitOf[n1];
+            if (!pdom.dominates(n2, p)) {
+                return;
+            }
+            int size = dom.subtreeSize(n1) - dom.subtreeSize(n2) + 1;
+            if ((best < 0) || (size < bestSize)) {
+                best = n1;
+                bestSize = size;
+            }
+        };
+        if (scan.exitOf[d] >= 0) {
+            int n2 = scan.exitOf[d];
+            bool inside = true;
+            for (size_t i = 0; inside && (i < inodes.size()); ++i) {
+                inside = (inodes[i] == n2) || !dom.dominates(n2, inodes[i]);
+            }
+            if (inside) {
+                consider(d);
+            }
+        }
+        int idom = dom.parent[d];
+        if ((first == last) && (idom != count) && (scan.exitOf[idom] == d)) {
+            consider(idom);
+        }
+        if (scan.up[d] >= 0) {
+            consider(scan.up[d]);
+        }
+        if (best < 0) {
+            DEBUGLOG("No simple subgraph holds the %d nodes\n", nodes.size());
+            return false;
+        }
+
+        int in2 = scan.exitOf[best];
+        out = subgraph_t(reverseMapNode(best), reverseMapNode(in2));
+        for (int k = dom.pre[best]; k < dom.last[best]; ++k) {
+            if ((k < dom.pre[in2]) || (k >= dom.last[in2])) {
+                out.nodes.insert(reverseMapNode(dom.order[k]));
+            }
+        }
+        out.nodes.insert(out.n2);
+        return true;
+    }
+
+    void RegionTree::clear() {
+        regions.clear();
+        // an empty tree still has an (empty) top level
+        childOffsets.assign(2, 0);
+        childList.clear();
+        ownOffsets.assign(1, 0);
+        ownList.clear();
+        order.clear();
+        position.clear();
+    }
+
+    int RegionTree::nodeCount(int r) const {
+        const region_t &reg = regions[r];
+        return (reg.last - reg.first) - (reg.holeLast - reg.holeFirst) + 1;
+    }
+
+    bool RegionTree::contains(int r, int node) const {
+        const region_t &reg = regions[r];
+        if (node == reg.n2) {
+            return true;
+        }
+        int pos = position.find(node);
+        if ((pos < reg.first) || (pos >= reg.last)) {
+            return false;
+        }
+        return (pos < reg.holeFirst) || (pos >= reg.holeLast);
+    }
+
+    void RegionTree::getNodes(int r, intset_t &out) const {
+        forEachNode(r, [&](int node) { out.insert(node); });
+    }
+
+    // the regions from scanSimpleRegions() are laminar: two regions are either
+    // nested or share at most one node, the exit of one being the entry of the
+    // next. so the enclosing region of every node can be pushed down the dominator
+    // tree in one preorder pass. a node is a region's exit only for the region
+    // starting at its idom, which leaves two candidate owners per node
+    bool FlareGraph::findRegionTree(RegionTree &out, unsigned int minNodeCount, unsigned int maxNodePercentage) {
+        out.clear();
+        if ((terminalsi(true).size() == 0) || (terminalsi(false).size() == 0)) {
+            LOG("No terminal or entry nodes. Empty graph\n");
+            return false;
+        }
+        AnalysisWorkspace::Scope scope(workspace);
+        arenaIntvector_t exits((ArenaAllocator<int>(workspace)));
+        scanSimpleRegions(exits, minNodeCount, maxNodePercentage, workspace);
+        int count = getNodeCount();
+        const DominanceIndex &dom = dominanceIndexi(false);
+        const intvector_t &order = dom.order;
+        const intvector_t &pre = dom.pre;
+        const intvector_t &parent = dom.parent;
+        int numbered = (int)order.size();
+
+        // the public layout leaves out the virtual entry, so positions are pre - 1
+        out.order.resize(numbered - 1);
+        for (int k = 1; k < numbered; ++k) {
+            out.order[k - 1] = reverseMapNode(order[k]);
+            out.position.insert(out.order[k - 1], k - 1);
+        }
+
+        // exitOf[n1] is n2 while regionAt[n1]/exitRegion[n2] hold region indexes
+        intvector_t exitOf(count + 1, -1);
+        intvector_t regionAt(count + 1, -1);
+        intvector_t exitRegion(count + 1, -1);
+        intvector_t regionExit;
+        for (auto it = exits.begin(); it != exits.end(); ++it) {
+            exitOf[parent[*it]] = *it;
+        }
+        // ctx[n]: innermost region holding n as anything but its exit
+        intvector_t ctx(count + 1, -1);
+        for (int k = 1; k < numbered; ++k) {
+            int v = order[k];
+            int p = parent[v];
+            int rp = regionAt[p];
+            if ((rp >= 0) && (regionExit[rp] != v)) {
+                ctx[v] = rp;
+            } else {
+                ctx[v] = ctx[p];
+            }
+            if (exitOf[v] < 0) {
+                continue;
+            }
+            int in2 = exitOf[v];
+            RegionTree::region_t reg;
+            reg.n1 = reverseMapNode(v);
+            reg.n2 = reverseMapNode(in2);
+            reg.parent = ctx[v];
+            reg.depth = (ctx[v] < 0) ? 0 : out.regions[ctx[v]].depth + 1;
+            reg.first = pre[v] - 1;
+            reg.last = dom.last[v] - 1;
+            reg.holeFirst = pre[in2] - 1;
+            reg.holeLast = dom.last[in2] - 1;
+            regionAt[v] = (int)out.regions.size();
+            exitRegion[in2] = regionAt[v];
+            regionExit.push_back(in2);
+            out.regions.push_back(reg);
+        }
+        int regionCount = out.size();
+
+        out.childOffsets.assign(regionCount + 2, 0);
+        for (int r = 0; r < regionCount; ++r) {
+            ++out.childOffsets[out.regions[r].parent + 2];
+        }
+        for (int r = 0; r <= regionCount; ++r) {
+            out.childOffsets[r + 1] += out.childOffsets[r];
+        }
+        out.childList.resize(regionCount);
+        intvector_t fill(out.childOffsets.begin(), out.childOffsets.end() - 1);
+        for (int r = 0; r < regionCount; ++r) {
+            out.childList[fill[out.regions[r].parent + 1]++] = r;
+        }
+
+        // a region r sits inside region q when r's entry is in q but isn't q's exit
+        auto inside = [&](int r, int q) {
+            const RegionTree::region_t &reg = out.regions[q];
+            int pos = out.regions[r].first;
+            return (pos >= reg.first) && (pos < reg.last) && ((pos < reg.holeFirst) || (pos >= reg.holeLast));
+        };
+        // owners[2k], owners[2k+1]: regions whose own set has node order[k + 1]
+        intvector_t owners(2 * (numbered - 1), -1);
+        out.ownOffsets.assign(regionCount + 1, 0);
+        for (int k = 1; k < numbered; ++k) {
+            int v = order[k];
+            int inner = (regionAt[v] >= 0) ? regionAt[v] : ctx[v];
+            int exit = exitRegion[v];
+            int *own = &owners[2 * (k - 1)];
+            if ((inner >= 0) && (exit >= 0)) {
+                if (inside(exit, inner)) {
+                    own[0] = exit;
+                } else if (inside(inner, exit)) {
+                    own[0] = inner;
+                } else {
+                    own[0] = inner;
+                    own[1] = exit;
+                }
+            } else {
+                own[0] = (inner >= 0) ? inner : exit;
+            }
+            for (int j = 0; j < 2; ++j) {
+                if (own[j] >= 0) {
+                    ++out.ownOffsets[own[j] + 1];
+                }
+            }
+        }
+        for (int r = 0; r < regionCount; ++r) {
+            out.ownOffsets[r + 1] += out.ownOffsets[r];
+        }
+        out.ownList.resize(out.ownOffsets[regionCount]);
+        fill.assign(out.ownOffsets.begin(), out.ownOffsets.end() - 1);
+        for (int k = 1; k < numbered; ++k) {
+            for (int j = 0; j < 2; ++j) {
+                int r = owners[2 * (k - 1) + j];
+                if (r >= 0) {
+                    out.ownList[fill[r]++] = out.order[k - 1];
+                }
+            }
+        }
+        DEBUGLOG("Found %d nested regions\n", regionCount);
+        return true;
+    }
+
+    // the regions are laminar, so the groups of a plan nest as long as no two of
+    // them chain, the exit of one being the entry of the other. a group's direct
+    // members are the own nodes of the regions under it, down to the nearest
+    // regions already in the plan, which are taken in whole as group nodes. every
+    // region is gathered that way at most once, by its closest planned ancestor
+    bool FlareGraph::planSimplification(collapsePlan_t &out, int targetNodeCount, unsigned int minNodeCount, unsigned int maxNodePercentage) {
+        out.clear();
+        RegionTree tree;
+        if (!findRegionTree(tree, minNodeCount, maxNodePercentage)) {
+            return false;
+        }
+        int regionCount = tree.size();
+        int visible = getNodeCount();
+
+        // a region is strictly bigger than any region inside it, so smallest first
+        // is inner first
+        intvector_t counts(regionCount);
+        intvector_t byCount(regionCount);
+        for (int r = 0; r < regionCount; ++r) {
+            counts[r] = tree.nodeCount(r);
+            byCount[r] = r;
+        }
+        std::stable_sort(byCount.begin(), byCount.end(), [&](int a, int b) { return counts[a] < counts[b]; });
+
+        // step[r] is r's index in the plan, -1 while r isn't in it. the rest are
+        // indexed by position in the tree's preorder layout
+        intvector_t step(regionCount, -1);
+        std::vector<char> grouped(tree.order.size(), 0);
+        std::vector<char> entryTaken(tree.order.size(), 0);
+        std::vector<char> exitTaken(tree.order.size(), 0);
+        intvector_t stack;
+        for (int i = 0; (i < regionCount) && (visible > targetNodeCount); ++i) {
+            int r = byCount[i];
+            const RegionTree::region_t &reg = tree.region(r);
+            int entryPos = reg.first;
+            int exitPos = tree.position.find(reg.n2);
+            if (entryTaken[exitPos] || exitTaken[entryPos]) {
+                DEBUGLOG("Passing over region <%d,%d>, it chains with a planned group\n", reg.n1, reg.n2);
+                continue;
+            }
+            collapse_t group;
+            group.n1 = reg.n1;
+            group.n2 = reg.n2;
+            stack.clear();
+            stack.push_back(r);
+            while (!stack.empty()) {
+                int q = stack.back();
+                stack.pop_back();
+                for (const int *it = tree.ownBegin(q); it != tree.ownEnd(q); ++it) {
+                    int pos = tree.position.find(*it);
+                    if (!grouped[pos]) {
+                        grouped[pos] = 1;
+                        group.nodes.push_back(*it);
+                    }
+                }
+                for (const int *it = tree.childBegin(q); it != tree.childEnd(q); ++it) {
+                    if (step[*it] >= 0) {
+                        group.groups.push_back(step[*it]);
+                    } else {
+                        stack.push_back(*it);
+                    }
+                }
+            }
+            visible -= (int)(group.nodes.size() + group.groups.size()) - 1;
+            group.visibleNodes = visible;
+
+            std::ostringstream label;
+            int in1 = mapNode(reg.n1);
+            int in2 = mapNode(reg.n2);
+            const areaVec_t &blocks = structure->blocks;
+            if (blocks[in1].end != blocks[in1].start) {
+                label << std::hex << "0x" << blocks[in1].start << " .. 0x" << blocks[in2].start << std::dec;
+            } else {
+                label << "<" << reg.n1 << "," << reg.n2 << ">";
+            }
+            label << " (" << counts[r] << " blocks)";
+            group.label = label.str();
+
+            step[r] = (int)out.size();
+            entryTaken[entryPos] = 1;
+            exitTaken[exitPos] = 1;
+            out.push_back(group);
+        }
+        DEBUGLOG("Planned %d groups, %d of %d nodes left visible\n", (int)out.size(), visible, getNodeCount());
+        return true;
+    }
+
+    void FlareGraph::syncGroupsi() {
+        if (groupStamp == structureGen) {
+            return;
+        }
+        int count = getNodeCount();
+        groupLink.resize(count);
+        groupSizes.assign(count, 1);
+        groupRoot.assign(count, 0);
+        groupMarks.assign(count, 0);
+        for (int i = 0; i < count; ++i) {
+            groupLink[i] = i;
+        }
+        quotientSuccs = structure->succs;
+        quotientPreds = structure->preds;
+        visibleCount = count;
+        for (auto it = contractions.begin(); it != contractions.end(); ++it) {
+            contractGroupi(*it);
+        }
+        groupStamp = structureGen;
+    }
+
+    // path halving
+    int FlareGraph::findGroupi(int in1) {
+        while (groupLink[in1] != in1) {
+            groupLink[in1] = groupLink[groupLink[in1]];
+            in1 = groupLink[in1];
+        }
+        return in1;
+    }
+
+    // the first member stays the root so groups keep the name they were given.
+    // without union by size a find is O(log V) amortized rather than inverse
+    // Ackermann, which is still far below what IDA spends drawing the group
+    int FlareGraph::contractGroupi(const intvector_t &members) {
+        int root = members[0];
+        for (auto it = members.begin() + 1; it != members.end(); ++it) {
+            groupLink[*it] = root;
+            groupSizes[root] += groupSizes[*it];
+        }
+        groupRoot[root] = 1;
+        visibleCount -= (int)members.size() - 1;
+        for (int post = 0; post < 2; ++post) {
+            array_of_intvector_t &adj = post ? quotientPreds : quotientSuccs;
+            intvector_t merged;
+            groupMarks[root] = 1;
+            for (auto it = members.begin(); it != members.end(); ++it) {
+                for (auto nit = adj[*it].begin(); nit != adj[*it].end(); ++nit) {
+                    int v = findGroupi(*nit);
+                    if (!groupMarks[v]) {
+                        groupMarks[v] = 1;
+                        merged.push_back(v);
+                    }
+                }
+                if (*it != root) {
+                    intvector_t().swap(adj[*it]);
+                }
+            }
+            groupMarks[root] = 0;
+            for (auto it = merged.begin(); it != merged.end(); ++it) {
+                groupMarks[*it] = 0;
+            }
+            adj[root].swap(merged);
+        }
+        return root;
+    }
+
+    // neighbours of a root still name the nodes they pointed at before those were
+    // contracted, so they are mapped through the forest and deduplicated here,
+    // and the compacted list is kept
+    void FlareGraph::quotientAdjacencyi(int in1, bool post, intvector_t &out) {
+        intvector_t &adj = post ? quotientPreds[in1] : quotientSuccs[in1];
+        size_t kept = 0;
+        groupMarks[in1] = 1;
+        for (size_t i = 0; i < adj.size(); ++i) {
+            int v = findGroupi(adj[i]);
+            if (!groupMarks[v]) {
+                groupMarks[v] = 1;
+                adj[kept++] = v;
+            }
+        }
+        adj.resize(kept);
+        groupMarks[in1] = 0;
+        out.clear();
+        for (auto it = adj.begin(); it != adj.end(); ++it) {
+            groupMarks[*it] = 0;
+            out.push_back(reverseMapNode(*it));
+        }
+    }
+
+    int FlareGraph::contractGroup(const intvector_t &members) {
+        if (members.size() == 0) {
+            LOG("Can't contract an empty group\n");
+            return -1;
+        }
+        syncGroupsi();
+        intvector_t imembers;
+        imembers.reserve(members.size());
+        for (auto it = members.begin(); it != members.end(); ++it) {
+            int in1 = mapNode(*it);
+            if (in1 < 0) {
+                LOG("Bad node name: %d\n", *it);
+                return -1;
+            }
+            if (findGroupi(in1) != in1) {
+                LOG("Node %d is hidden in group %d\n", *it, reverseMapNode(findGroupi(in1)));
+                return -1;
+            }
+            if (groupMarks[in1]) {
+                continue;
+            }
+            groupMarks[in1] = 1;
+            imembers.push_back(in1);
+        }
+        for (auto it = imembers.begin(); it != imembers.end(); ++it) {
+            groupMarks[*it] = 0;
+        }
+        contractions.push_back(imembers);
+        return reverseMapNode(contractGroupi(imembers));
+    }
+
+    // the outermost group holding a node is the last contraction whose name is
+    // that node's root, as a group only keeps its name when it's contracted
+    // into a bigger group as that group's first member. anything contracted
+    // after it either doesn't touch it or holds it, so dropping it leaves a
+    // valid history to replay
+    bool FlareGraph::expandGroup(int name) {
+        int in1 = mapNode(name);
+        if (in1 < 0) {
+            return false;
+        }
+        syncGroupsi();
+        int root = findGroupi(in1);
+        if (!groupRoot[root]) {
+            return false;
+        }
+        for (int i = (int)contractions.size() - 1; i >= 0; --i) {
+            if (contractions[i][0] == root) {
+                contractions.erase(contractions.begin() + i);
+                break;
             }
         }
-        return verifySimpleSubGraphs(out, candidates, minNodeCount, maxNodePercentage);
+        groupStamp = 0;
+        return true;
+    }
+
+    void FlareGraph::clearGroups() {
+        contractions.clear();
+        groupStamp = 0;
+    }
+
+    int FlareGraph::groupOf(int name) {
+        int in1 = mapNode(name);
+        if (in1 < 0) {
+            return -1;
+        }
+        syncGroupsi();
+        return reverseMapNode(findGroupi(in1));
+    }
+
+    bool FlareGraph::isGrouped(int name) {
+        int in1 = mapNode(name);
+        if (in1 < 0) {
+            return false;
+        }
+        syncGroupsi();
+        return groupRoot[findGroupi(in1)] != 0;
+    }
+
+    int FlareGraph::groupNodeCount(int name) {
+        int in1 = mapNode(name);
+        if (in1 < 0) {
+            return 0;
+        }
+        syncGroupsi();
+        return groupSizes[findGroupi(in1)];
+    }
+
+    int FlareGraph::getVisibleCount() {
+        syncGroupsi();
+        return visibleCount;
+    }
+
+    bool FlareGraph::visibleNodes(intvector_t &out) {
+        syncGroupsi();
+        out.clear();
+        out.reserve(visibleCount);
+        for (int i = 0; i < getNodeCount(); ++i) {
+            if (groupLink[i] == i) {
+                out.push_back(reverseMapNode(i));
+            }
+        }
+        return true;
+    }
+
+    bool FlareGraph::visibleSuccs(int name, intvector_t &out) {
+        int in1 = mapNode(name);
+        if (in1 < 0) {
+            return false;
+        }
+        syncGroupsi();
+        quotientAdjacencyi(findGroupi(in1), false, out);
+        return true;
+    }
+
+    bool FlareGraph::visiblePreds(int name, intvector_t &out) {
+        int in1 = mapNode(name);
+        if (in1 < 0) {
+            return false;
+        }
+        syncGroupsi();
+        quotientAdjacencyi(findGroupi(in1), true, out);
+        return true;
     }
 
     //given a set of pairs of <dom,pdom>, verifies if they actually 
-    bool FlareGraph::verifySimpleSubGraphs(subgraphVec_t &out, intintPairSet_t &candidates, unsigned int minNodeCount, unsigned int maxNodePercentage) {
+    // each candidate is checked on its own against the frozen graph, so the checks
+    // are shared out over worker threads. workers take the next batch of candidates
+    // off a shared counter and write to that candidate's slot, which keeps the
+    // output in candidate order. if a thread can't be started the ones already
+    // running share the work. an exception in any worker stops the others and
+    // makes this return false once they're all joined
+    bool FlareGraph::verifySimpleSubGraphs(subgraphVec_t &out, const arenaIntintPairVec_t &candidates, unsigned int minNodeCount, unsigned int maxNodePercentage, AnalysisWorkspace &ws) {
+        const FrozenGraph &fg = frozen();
+        intvector_t roots(terminalsi(true));
+        const intvector_t &entries = terminalsi(false);
+        roots.insert(roots.end(), entries.begin(), entries.end());
+        const DominanceIndex &dom = dominanceIndexi(false);
+
+        arenaIntintPairVec_t pairs((ArenaAllocator<intintPair_t>(ws)));
+        pairs.reserve(candidates.size());
         for (auto it = candidates.begin(); it != candidates.end(); ++it) {
-            int n1 = it->first;
-            int n2 = it->second;
-            subgraph_t res(n1, n2);
-            bool ret = isSimpleSubGraph(n1, n2, res, minNodeCount, maxNodePercentage);
-            if (ret) {
+            int in1 = mapNode(it->first);
+            int in2 = mapNode(it->second);
+            if ((in1 >= 0) && (in2 >= 0)) {
+                pairs.push_back(std::make_pair(in1, in2));
+            }
+        }
+        if (pairs.empty()) {
+            return true;
+        }
+
+        // small jobs aren't worth starting threads for
+        const size_t batch = 16;
+        unsigned int threads = threadCount ? threadCount : std::thread::hardware_concurrency();
+        if ((double)pairs.size() * fg.nodeCount() < (1 << 16)) {
+            threads = 1;
+        }
+        threads = (unsigned int)(std::min)((size_t)(std::max)(threads, 1u), (pairs.size() + batch - 1) / batch);
+
+        subgraphVec_t results(pairs.size(), subgraph_t(-1, -1));
+        std::vector<char, ArenaAllocator<char> > passed(pairs.size(), 0, ArenaAllocator<char>(ws));
+        std::atomic<size_t> next(0);
+        // one slot per thread, so the workers never share one
+        std::vector<std::exception_ptr> errors(threads);
+        auto worker = [&](unsigned int slot) {
+            try {
+                NodeSet region(fg.nodeCount());
+                intvector_t stack;
+                for (size_t first = next.fetch_add(batch); first < pairs.size(); first = next.fetch_add(batch)) {
+                    size_t last = (std::min)(first + batch, pairs.size());
+                    for (size_t i = first; i < last; ++i) {
+                        int in1 = pairs[i].first;
+                        int in2 = pairs[i].second;
+                        results[i].n1 = reverseMapNode(in1);
+                        results[i].n2 = reverseMapNode(in2);
+                        passed[i] = checkSubGraphi(in1, in2, roots, dom, region, stack, results[i], minNodeCount, maxNodePercentage);
+                    }
+                }
+            } catch (...) {
+                errors[slot] = std::current_exception();
+                next.store(pairs.size());
+            }
+        };
+        std::vector<std::thread> pool;
+        try {
+            pool.reserve(threads);
+            for (unsigned int t = 1; t < threads; ++t) {
+                pool.push_back(std::thread(worker, t));
+            }
+        } catch (const std::exception &e) {
+            LOG("Verifying subgraphs on %u threads instead of %u: %s\n", (unsigned int)pool.size() + 1, threads, e.what());
+        }
+        worker(0);
+        for (size_t t = 0; t < pool.size(); ++t) {
+            pool[t].join();
+        }
+        for (size_t t = 0; t < errors.size(); ++t) {
+            if (!errors[t]) {
+                continue;
+            }
+            try {
+                std::rethrow_exception(errors[t]);
+            } catch (const std::exception &e) {
+                LOG("Subgraph verification failed: %s\n", e.what());
+            } catch (...) {
+                LOG("Subgraph verification failed\n");
+            }
+            return false;
+        }
+
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            if (passed[i]) {
                 DEBUGEXEC({
-                    DEBUGLOG("Found simple graph <%d,%d>: %d nodes\n", n1, n2, res.nodes.size());
-                    for (auto nit = res.nodes.begin(); nit != res.nodes.end(); ++nit) {
+                    DEBUGLOG("Found simple graph <%d,%d>: %d nodes\n", results[i].n1, results[i].n2, results[i].nodes.size());
+                    for (auto nit = results[i].nodes.begin(); nit != results[i].nodes.end(); ++nit) {
                         DEBUGLOG("  %d\n", *nit);
                     }
                 });
-                out.push_back(res);
+                out.push_back(subgraph_t(results[i].n1, results[i].n2));
+                out.back().nodes.swap(results[i].nodes);
             } else {
-                DEBUGLOG("Skipping simple graph <%d,%d>\n", n1, n2);
+                DEBUGLOG("Skipping simple graph <%d,%d>\n", results[i].n1, results[i].n2);
             }
         }
         return true; 
@@ -998,75 +2926,389 @@ namespace Flare {
             return false;
         }
   
-        intdeque_t pendingAnalysis;
-        //queue the entry point node we're trying to collapse
-        pendingAnalysis.push_back(in1);
+        const FrozenGraph &fg = frozen();
+        intvector_t roots(terminalsi(true));
+        const intvector_t &entries = terminalsi(false);
+        roots.insert(roots.end(), entries.begin(), entries.end());
+        const DominanceIndex &dom = dominanceIndexi(false);
+        NodeSet region(fg.nodeCount());
+        return checkSubGraphi(in1, in2, roots, dom, region, walkStack, outgraph, minNodeCount, maxNodePercentage);
+    }
 
-        //add the good ipdom so we don't follow its successors in the graph traversal
-        outgraph.nodes.insert(n2);
-
-        while (pendingAnalysis.size() > 0) {
-            int pnode = pendingAnalysis.back();
-            pendingAnalysis.pop_back();
-            int opnode = reverseMapNode(pnode);
-            DEBUGLOG("Examining opnode %d\n", opnode);
-            if (intsetHas(outgraph.nodes, opnode)) {
-                // already in the output set, don't follow successors
-                continue;
+    bool FlareGraph::checkSubGraphi(int in1, int in2, const intvector_t &roots, const DominanceIndex &dom, NodeSet &region, intvector_t &stack,
+                                    subgraph_t &outgraph, unsigned int minNodeCount, unsigned int maxNodePercentage) const {
+        const FrozenGraph &fg = structure->frozenGraph;
+        outgraph.nodes.clear();
+        if ((in1 != in2) && dom.dominates(in1, in2)) {
+            // the walk covers at least n1's dominator subtree minus n2's, plus n2.
+            // anything more means a node with a predecessor outside the region, so
+            // a good subgraph has exactly that size and the limits can go first
+            unsigned int size = dom.subtreeSize(in1) - dom.subtreeSize(in2) + 1;
+            unsigned int coverPercentInt = (unsigned int)(double(size)/getNodeCount()*100.0);
+            if ((size < minNodeCount) || (coverPercentInt > maxNodePercentage)) {
+                DEBUGLOG("Subgraph <%d,%d> out of size limits: %d nodes\n", reverseMapNode(in1), reverseMapNode(in2), size);
+                return false;
             }
-            if ((opnode != in2) && (nsucc(opnode) == 0)) {
+        }
+        region.clear();
+        //add the good ipdom so we don't follow its successors in the graph traversal
+        region.insert(in2);
+        //traverse from the entry point node we're trying to collapse
+        stack.clear();
+        stack.push_back(in1);
+        walk<SuccDir>(fg, stack, region, AllNodes(), NoVisit());
+        // checks the stand-in exits and entries of closed loops as well. an entry
+        // other than n1 is only reachable here if it sits on a loop
+        for (size_t t = 0; t < roots.size(); ++t) {
+            int pnode = roots[t];
+            if ((pnode != in1) && (pnode != in2) && region.has(pnode)) {
                 // not a problem. means we encountered found another termina
-                DEBUGLOG("Found unexpected terminal during %d:( %08x ) %d:( %08x ) verification: %d:( %08x )\n", n1, getNodeAreaStart(n1), n2, getNodeAreaStart(n2), opnode, getNodeAreaStart(opnode));
-                outgraph.nodes.clear();
+                DEBUGLOG("Found unexpected terminal during %d:( %08x ) %d:( %08x ) verification: %d:( %08x )\n", reverseMapNode(in1), getNodeAreaStart(reverseMapNode(in1)), reverseMapNode(in2), getNodeAreaStart(reverseMapNode(in2)), reverseMapNode(pnode), getNodeAreaStart(reverseMapNode(pnode)));
                 return false;
             }
-            // add to output
-            outgraph.nodes.insert(opnode);
-            // queue all children nodes for analysis
-            for (int k = 0; k < nsucci(pnode); ++k) {
-                int snode = succi(pnode, k);
-                int osnode = reverseMapNode(snode);
-                if ((!intsetHas(outgraph.nodes, osnode) && (!intdequeHas(pendingAnalysis, snode)))) {
-                    DEBUGLOG("Queueing successor ext %d -> %d\n", opnode, osnode);
-                    pendingAnalysis.push_back(snode);
-                }
-            }
         }
-        if (outgraph.nodes.size() < minNodeCount) {
-            DEBUGLOG("Subgraph too small <%d,%d>: %d nodes > %d\n", n1, n2, outgraph.nodes.size(), minNodeCount);
-            outgraph.nodes.clear();
+        if ((unsigned int)region.size() < minNodeCount) {
+            DEBUGLOG("Subgraph too small <%d,%d>: %d nodes > %d\n", reverseMapNode(in1), reverseMapNode(in2), region.size(), minNodeCount);
             return false;
         }
-        double coverPercent = double(outgraph.nodes.size())/getNodeCount();
+        double coverPercent = double(region.size())/getNodeCount();
         unsigned int coverPercentInt = (unsigned int) (coverPercent*100.0);
         if (coverPercentInt > maxNodePercentage) {
-            DEBUGLOG("Subgraph too big <%d,%d>: %d nodes. %d percent > %d\n", n1, n2, outgraph.nodes.size(), coverPercentInt, maxNodePercentage);
-            outgraph.nodes.clear();
+            DEBUGLOG("Subgraph too big <%d,%d>: %d nodes. %d percent > %d\n", reverseMapNode(in1), reverseMapNode(in2), region.size(), coverPercentInt, maxNodePercentage);
             return false;
         }
         bool toret = true;
         //make sure that only the dominator is has predecessors not in the candiate subgraph
-        for (auto it = outgraph.nodes.begin(); it != outgraph.nodes.end(); ++it) {
-            if (!toret) {
-                break;
+        region.forEach([&](int inode) {
+            if (!toret || (inode == in1)) {
+                return;
             }
-            if (*it == n1) {
-                continue;
-            }
-            for (int j = 0; j < npred(*it); ++j) {
-                int pnode = pred(*it, j);
-                if (!intsetHas(outgraph.nodes, pnode)) {
+            for (const int *pit = fg.predBegin(inode); pit != fg.predEnd(inode); ++pit) {
+                if (!region.has(*pit)) {
                     // predecessor not in 
-                    DEBUGLOG("Subgraph has invalide predecessor <%d,%d>: %d->%d\n", n1, n2, pnode, *it);
+                    DEBUGLOG("Subgraph has invalide predecessor <%d,%d>: %d->%d\n", reverseMapNode(in1), reverseMapNode(in2), reverseMapNode(*pit), reverseMapNode(inode));
                     toret = false;
                     break;
                 }
             }
-        }
+        });
         if(!toret) {
-            outgraph.nodes.clear();
             return false;
         }
+        region.forEach([&](int inode) { outgraph.nodes.insert(reverseMapNode(inode)); });
+        return true;
+    }
+
+    // iterative Tarjan. the explicit stack holds (node, next edge) frames, so deep
+    // graphs can't overflow the call stack
+    const intvector_t &FlareGraph::scci() {
+        if (sccCache.valid(structureGen)) {
+            return sccCache.value;
+        }
+        const FrozenGraph &fg = frozen();
+        int count = fg.nodeCount();
+        intvector_t &comp = sccCache.value;
+        comp.assign(count, -1);
+        intvector_t index(count, -1);
+        intvector_t low(count, 0);
+        intvector_t open;
+        dfsStack_t frames;
+        int counter = 0;
+        int components = 0;
+        for (int start = 0; start < count; ++start) {
+            if (index[start] >= 0) {
+                continue;
+            }
+            index[start] = low[start] = counter++;
+            open.push_back(start);
+            frames.push_back(std::make_pair(start, fg.succBegin(start)));
+            while (!frames.empty()) {
+                int v = frames.back().first;
+                if (frames.back().second != fg.succEnd(v)) {
+                    int w = *frames.back().second++;
+                    if (index[w] < 0) {
+                        index[w] = low[w] = counter++;
+                        open.push_back(w);
+                        frames.push_back(std::make_pair(w, fg.succBegin(w)));
+                    } else if (comp[w] < 0) {
+                        // still open, so on the current path's component stack
+                        low[v] = (std::min)(low[v], index[w]);
+                    }
+                    continue;
+                }
+                frames.pop_back();
+                if (low[v] == index[v]) {
+                    int w;
+                    do {
+                        w = open.back();
+                        open.pop_back();
+                        comp[w] = components;
+                    } while (w != v);
+                    ++components;
+                }
+                if (!frames.empty()) {
+                    int u = frames.back().first;
+                    low[u] = (std::min)(low[u], low[v]);
+                }
+            }
+        }
+        sccCache.stamp = structureGen;
+        return comp;
+    }
+
+    int FlareGraph::stronglyConnectedComponents(intvector_t &out) {
+        const intvector_t &comp = scci();
+        int components = 0;
+        for (int i = 0; i < (int)comp.size(); ++i) {
+            components = (std::max)(components, comp[i] + 1);
+        }
+        if (structure->identityNames) {
+            out = comp;
+            return components;
+        }
+        int maxName = -1;
+        for (int i = 0; i < (int)comp.size(); ++i) {
+            maxName = (std::max)(maxName, reverseMapNode(i));
+        }
+        out.assign(maxName + 1, -1);
+        for (int i = 0; i < (int)comp.size(); ++i) {
+            out[reverseMapNode(i)] = comp[i];
+        }
+        return components;
+    }
+
+    void LoopForest::clear() {
+        loops.clear();
+        childOffsets.assign(2, 0);
+        childList.clear();
+        bodyOffsets.assign(1, 0);
+        bodyList.clear();
+        innermost.clear();
+    }
+
+    bool LoopForest::contains(int l, int node) const {
+        int inner = loopOf(node);
+        return (inner >= l) && (inner < loops[l].last);
+    }
+
+    void LoopForest::getNodes(int l, intset_t &out) const {
+        out.insert(nodesBegin(l), nodesEnd(l));
+    }
+
+    // Havlak's algorithm, on DFS preorder numbers:
+    //   1) number the nodes in DFS preorder, keeping the last descendant of each
+    //   2) from the last number to the first, a node w with back edges into it heads
+    //      a loop. the body is collected backwards from the back edge sources over
+    //      the non-back edges, with every node already placed in an inner loop
+    //      standing in for that whole loop (union-find)
+    //   3) a non-back edge from outside w's DFS subtree makes the loop irreducible;
+    //      the source is then handed on to w so the enclosing loop sees it
+    bool FlareGraph::findLoopForest(LoopForest &out) {
+        out.clear();
+        const FrozenGraph &fg = frozen();
+        int count = fg.nodeCount();
+
+        // 1)
+        intvector_t num(count, -1);
+        intvector_t node;
+        intvector_t last(count, 0);
+        node.reserve(count);
+        NodeSet seen(count);
+        dfsStack_t dfsStack;
+        auto discover = [&](int n, int) {
+            num[n] = (int)node.size();
+            node.push_back(n);
+        };
+        auto finish = [&](int n) { last[num[n]] = (int)node.size() - 1; };
+        const intvector_t &entries = terminalsi(false);
+        for (int k = 0; k < (int)entries.size() + count; ++k) {
+            int start = k < (int)entries.size() ? entries[k] : k - (int)entries.size();
+            dfs<SuccDir>(fg, start, dfsStack, seen, AllNodes(), discover, finish);
+        }
+        auto isAncestor = [&last](int w, int v) { return (w <= v) && (v <= last[w]); };
+
+        // 2)
+        intvector_t header(count, -1);
+        std::vector<bool> isHeader(count, false);
+        std::vector<bool> reducible(count, true);
+        intvector_t uf(count);
+        for (int w = 0; w < count; ++w) {
+            uf[w] = w;
+        }
+        intvector_t compressStack;
+        auto find = [&uf, &compressStack](int x) {
+            compressStack.clear();
+            while (uf[x] != x) {
+                compressStack.push_back(x);
+                x = uf[x];
+            }
+            for (size_t i = 0; i < compressStack.size(); ++i) {
+                uf[compressStack[i]] = x;
+            }
+            return x;
+        };
+        // sources handed on from irreducible inner loops, by preorder number
+        std::vector<intvector_t> extraPreds(count);
+        intvector_t inBody(count, -1);
+        intvector_t body;
+        intvector_t worklist;
+        for (int w = count - 1; w >= 0; --w) {
+            body.clear();
+            int wnode = node[w];
+            for (const int *pit = fg.predBegin(wnode); pit != fg.predEnd(wnode); ++pit) {
+                int v = num[*pit];
+                if (!isAncestor(w, v)) {
+                    continue;
+                }
+                if (v == w) {
+                    isHeader[w] = true;
+                    continue;
+                }
+                int x = find(v);
+                if (inBody[x] != w) {
+                    inBody[x] = w;
+                    body.push_back(x);
+                }
+            }
+            if (body.empty()) {
+                continue;
+            }
+            isHeader[w] = true;
+            worklist.assign(body.begin(), body.end());
+            while (!worklist.empty()) {
+                int x = worklist.back();
+                worklist.pop_back();
+                int xnode = node[x];
+                const int *pit = fg.predBegin(xnode);
+                size_t extra = 0;
+                while (true) {
+                    int y;
+                    if (pit != fg.predEnd(xnode)) {
+                        y = num[*pit++];
+                        if (isAncestor(x, y)) {
+                            // back edge into x, already handled when x was processed
+                            continue;
+                        }
+                    } else if (extra < extraPreds[x].size()) {
+                        y = extraPreds[x][extra++];
+                    } else {
+                        break;
+                    }
+                    int yrep = find(y);
+                    if (!isAncestor(w, yrep)) {
+                        reducible[w] = false;
+                        extraPreds[w].push_back(yrep);
+                    } else if ((yrep != w) && (inBody[yrep] != w)) {
+                        inBody[yrep] = w;
+                        body.push_back(yrep);
+                        worklist.push_back(yrep);
+                    }
+                }
+            }
+            for (size_t i = 0; i < body.size(); ++i) {
+                header[body[i]] = w;
+                uf[body[i]] = w;
+            }
+        }
+
+        // 3) loops in preorder of the forest. headers in DFS preorder already put
+        // every loop after the loop enclosing it
+        intvector_t loopOfHeader(count, -1);
+        intvector_t headers;
+        for (int w = 0; w < count; ++w) {
+            if (isHeader[w]) {
+                loopOfHeader[w] = (int)headers.size();
+                headers.push_back(w);
+            }
+        }
+        int loopCount = (int)headers.size();
+        // children by header order, then a forest walk for the final indices
+        intvector_t kidOffsets(loopCount + 2, 0);
+        for (int h = 0; h < loopCount; ++h) {
+            int p = header[headers[h]];
+            ++kidOffsets[(p < 0 ? 0 : loopOfHeader[p] + 1) + 1];
+        }
+        for (int h = 0; h <= loopCount; ++h) {
+            kidOffsets[h + 1] += kidOffsets[h];
+        }
+        intvector_t kids(loopCount);
+        intvector_t fill(kidOffsets.begin(), kidOffsets.end() - 1);
+        for (int h = 0; h < loopCount; ++h) {
+            int p = header[headers[h]];
+            kids[fill[p < 0 ? 0 : loopOfHeader[p] + 1]++] = h;
+        }
+        intvector_t finalIndex(loopCount, -1);
+        out.loops.resize(loopCount);
+        walkStack.clear();
+        for (int k = kidOffsets[1] - 1; k >= kidOffsets[0]; --k) {
+            walkStack.push_back(kids[k]);
+        }
+        int next = 0;
+        // walkStack holds header indices to enter; entries of -(1 + h) close loop h
+        while (!walkStack.empty()) {
+            int h = walkStack.back();
+            walkStack.pop_back();
+            if (h < 0) {
+                out.loops[finalIndex[-h - 1]].last = next;
+                continue;
+            }
+            int l = next++;
+            finalIndex[h] = l;
+            LoopForest::loop_t &lp = out.loops[l];
+            int w = headers[h];
+            lp.header = reverseMapNode(node[w]);
+            lp.parent = header[w] < 0 ? -1 : finalIndex[loopOfHeader[header[w]]];
+            lp.depth = lp.parent < 0 ? 0 : out.loops[lp.parent].depth + 1;
+            lp.reducible = reducible[w];
+            walkStack.push_back(-h - 1);
+            for (int k = kidOffsets[h + 2] - 1; k >= kidOffsets[h + 1]; --k) {
+                walkStack.push_back(kids[k]);
+            }
+        }
+
+        // child lists in final order
+        out.childOffsets.assign(loopCount + 2, 0);
+        for (int l = 0; l < loopCount; ++l) {
+            ++out.childOffsets[out.loops[l].parent + 2];
+        }
+        for (int l = 0; l <= loopCount; ++l) {
+            out.childOffsets[l + 1] += out.childOffsets[l];
+        }
+        out.childList.resize(loopCount);
+        fill.assign(out.childOffsets.begin(), out.childOffsets.end() - 1);
+        for (int l = 0; l < loopCount; ++l) {
+            out.childList[fill[out.loops[l].parent + 1]++] = l;
+        }
+
+        // bodies. every node is in the innermost loop it heads or was collected into
+        intvector_t inner(count, -1);
+        out.bodyOffsets.assign(loopCount + 1, 0);
+        for (int w = 0; w < count; ++w) {
+            int h = isHeader[w] ? w : header[w];
+            if (h >= 0) {
+                inner[w] = finalIndex[loopOfHeader[h]];
+                ++out.bodyOffsets[inner[w] + 1];
+            }
+        }
+        for (int l = 0; l < loopCount; ++l) {
+            out.bodyOffsets[l + 1] += out.bodyOffsets[l];
+        }
+        out.bodyList.resize(out.bodyOffsets[loopCount]);
+        fill.assign(out.bodyOffsets.begin(), out.bodyOffsets.end() - 1);
+        for (int l = 0; l < loopCount; ++l) {
+            out.bodyList[fill[l]++] = out.loops[l].header;
+        }
+        for (int w = 0; w < count; ++w) {
+            if ((inner[w] >= 0) && !isHeader[w]) {
+                out.bodyList[fill[inner[w]]++] = reverseMapNode(node[w]);
+            }
+        }
+        for (int w = 0; w < count; ++w) {
+            if (inner[w] >= 0) {
+                out.innermost.insert(reverseMapNode(node[w]), inner[w]);
+            }
+        }
+        DEBUGLOG("Found %d loops\n", loopCount);
         return true;
     }
 }
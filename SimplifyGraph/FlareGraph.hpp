@@ -38,6 +38,15 @@ namespace Flare {
         Sentry,
     };
 
+    // how getDomIntMap()/getpdomGroup()/findSimpleSubGraphs() combine the trees of
+    // several terminals (or entries)
+    enum class DomMode {
+        // one tree per terminal, merged with the IPDOM_UNKNOWN/IPDOM_CONFLICT rules
+        PerRoot = 0,
+        // a single tree from a virtual exit (or entry) joined to every terminal
+        VirtualRoot,
+    };
+
     typedef std::vector<int> intvector_t;
     typedef std::set<NodeProperty> nodepropset_t;
     typedef std::set<int> intset_t;
@@ -68,14 +77,42 @@ namespace Flare {
     };
     typedef std::vector<area_t> areaVec_t;
 
+    // compressed sparse row (CSR) snapshot of a graph's adjacency, created by
+    // FlareGraph::freeze(). the successors of internal node n are stored in
+    // succTargets[succOffsets[n]] up to (but excluding) succTargets[succOffsets[n+1]],
+    // and the predecessors likewise in predTargets. all node ids are internal names.
+    // traversals walk these flat arrays instead of chasing one heap vector per node.
+    struct FrozenGraph {
+        intvector_t succOffsets;
+        intvector_t succTargets;
+        intvector_t predOffsets;
+        intvector_t predTargets;
+
+        int nodeCount() const { return succOffsets.empty() ? 0 : (int)succOffsets.size() - 1; }
+        int edgeCount() const { return (int)succTargets.size(); }
+
+        int nsucc(int n) const { return succOffsets[n + 1] - succOffsets[n]; }
+        int npred(int n) const { return predOffsets[n + 1] - predOffsets[n]; }
+
+        const int *succBegin(int n) const { return succTargets.data() + succOffsets[n]; }
+        const int *succEnd(int n) const { return succTargets.data() + succOffsets[n + 1]; }
+        const int *predBegin(int n) const { return predTargets.data() + predOffsets[n]; }
+        const int *predEnd(int n) const { return predTargets.data() + predOffsets[n + 1]; }
+
+        void clear() {
+            succOffsets.clear();
+            succTargets.clear();
+            predOffsets.clear();
+            predTargets.clear();
+        }
+    };
+
     typedef boost::adjacency_list<
         boost::vecS,
         boost::vecS,
         boost::bidirectionalS,
         boost::property<boost::vertex_index_t, std::size_t>,
         boost::no_property> DomGraph;
-    typedef std::map<int, nodepropset_t>::const_iterator nodepropiter_t;
-    typedef nodepropset_t::const_iterator propiter_t;
     typedef boost::adjacency_list<
         boost::vecS,
         boost::vecS,
@@ -87,6 +124,369 @@ namespace Flare {
     typedef std::map<Vertex, Vertex> VertexVertexMap;
 
 
+    // monotonic arena for the temporaries of the subgraph analyses. memory comes
+    // from a list of heap blocks and is only given back as a whole, when the
+    // outermost Scope ends. if that round needed more than one block, the blocks
+    // are swapped for a single one big enough for all of it, so repeating the
+    // same analysis settles on one block and no heap allocations at all.
+    // not thread safe: worker threads keep their own scratch space
+    class AnalysisWorkspace {
+    public:
+        AnalysisWorkspace() : current(0), used(0), depth(0), heapAllocations(0) { }
+        ~AnalysisWorkspace();
+
+        void *allocate(size_t bytes, size_t align);
+
+        // marks the workspace and rewinds it to the mark when it goes away. the
+        // analysis entry points open one, so nested calls share the workspace
+        class Scope {
+        public:
+            explicit Scope(AnalysisWorkspace &ws) : ws(ws), block(ws.current), used(ws.used) { ++ws.depth; }
+            ~Scope() { ws.rewind(block, used); }
+        private:
+            Scope(const Scope &other);
+            Scope &operator=(const Scope &other);
+            AnalysisWorkspace &ws;
+            size_t block;
+            size_t used;
+        };
+
+        // number of blocks taken from the heap so far, for telling if repeated
+        // analyses still allocate
+        size_t getHeapAllocations() const { return heapAllocations; }
+        size_t getCapacity() const;
+
+    private:
+        AnalysisWorkspace(const AnalysisWorkspace &other);
+        AnalysisWorkspace &operator=(const AnalysisWorkspace &other);
+
+        void rewind(size_t block, size_t used);
+
+        struct block_t {
+            char *data;
+            size_t size;
+        };
+        std::vector<block_t> blocks;
+        size_t current;
+        size_t used;
+        int depth;
+        size_t heapAllocations;
+    };
+
+    // STL allocator over an AnalysisWorkspace. deallocate() does nothing, so
+    // containers using it should be sized up front rather than grown
+    template <class T>
+    class ArenaAllocator {
+    public:
+        typedef T value_type;
+        typedef T *pointer;
+        typedef const T *const_pointer;
+        typedef T &reference;
+        typedef const T &const_reference;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+        template <class U> struct rebind { typedef ArenaAllocator<U> other; };
+
+        explicit ArenaAllocator(AnalysisWorkspace &ws) : workspace(&ws) { }
+        template <class U> ArenaAllocator(const ArenaAllocator<U> &other) : workspace(other.workspace) { }
+
+        T *allocate(size_type n) { return static_cast<T *>(workspace->allocate(n * sizeof(T), std::alignment_of<T>::value)); }
+        void deallocate(T *, size_type) { }
+        size_type max_size() const { return ((size_type)-1) / sizeof(T); }
+
+        bool operator==(const ArenaAllocator &other) const { return workspace == other.workspace; }
+        bool operator!=(const ArenaAllocator &other) const { return workspace != other.workspace; }
+
+        AnalysisWorkspace *workspace;
+    };
+    typedef std::vector<int, ArenaAllocator<int> > arenaIntvector_t;
+    typedef std::vector<intintPair_t, ArenaAllocator<intintPair_t> > arenaIntintPairVec_t;
+
+
+    // external -> internal node name lookup used when the public names aren't simply
+    // 0..n-1. names that fit are kept in a flat vector indexed by the name. once a name
+    // would make that vector too sparse, the table switches over to open addressing
+    // with linear probing. only non-negative names and values are supported.
+    class NodeNameTable {
+    public:
+        NodeNameTable() : count(0), hashed(false) { }
+
+        // returns the value stored for name, or -1 if not present
+        int find(int name) const;
+
+        // add or overwrite the value for name
+        void insert(int name, int value);
+
+        void clear();
+        int size() const { return count; }
+
+    private:
+        // flat[name] = value, -1 for unused slots. only used while !hashed
+        intvector_t flat;
+        // open addressing table, keys of -1 mark empty slots. size is a power of 2
+        intvector_t keys;
+        intvector_t values;
+        int count;
+        bool hashed;
+
+        unsigned int slot(int name) const;
+        void rehash(size_t capacity);
+    };
+
+    // set of internal node ids backed by a bitset, used for the visited/output sets
+    // of the graph algorithms. graphs up to NODESET_DENSE_LIMIT nodes get one flat
+    // array of words. beyond that the bits are split into fixed size chunks that are
+    // only allocated once a member lands in them, so small sets over very large
+    // graphs stay small. either way has/insert/erase are O(1) and set operations
+    // work a word at a time.
+    class NodeSet {
+    public:
+        NodeSet() : chunked(false), universe(0), members(0) { }
+        explicit NodeSet(int universe) : chunked(false), universe(0), members(0) { reset(universe); }
+
+        // empty the set and size it for node ids 0..universe-1
+        void reset(int universe);
+
+        // empty the set, keeping its current size
+        void clear();
+
+        bool has(int n) const {
+            if ((unsigned int)n >= (unsigned int)universe) {
+                return false;
+            }
+            const uint64_t *w = word(n);
+            return w && ((*w >> (n & 63)) & 1);
+        }
+
+        // returns true if n wasn't already in the set. n must be below universeSize()
+        bool insert(int n) {
+            uint64_t *w = wordAlloc(n);
+            uint64_t bit = (uint64_t)1 << (n & 63);
+            if (*w & bit) {
+                return false;
+            }
+            *w |= bit;
+            ++members;
+            return true;
+        }
+
+        // returns true if n was in the set
+        bool erase(int n) {
+            if (!has(n)) {
+                return false;
+            }
+            *wordAlloc(n) &= ~((uint64_t)1 << (n & 63));
+            --members;
+            return true;
+        }
+
+        int size() const { return members; }
+        bool empty() const { return members == 0; }
+        int universeSize() const { return universe; }
+
+        // this = this - other. other may have a different universe size or layout,
+        // members of other outside this universe are ignored
+        void subtract(const NodeSet &other);
+
+        // flip membership of every node in the universe
+        void complement();
+
+        // this = this | other. other may be smaller or use the other layout, but
+        // must not have members at or beyond this universeSize()
+        void unite(const NodeSet &other);
+
+        // calls f(n) for every member, in increasing order
+        template<typename F> void forEach(F f) const {
+            for (unsigned int c = 0; c < chunkCount(); ++c) {
+                const uint64_t *cw = chunkWords(c);
+                if (!cw) {
+                    continue;
+                }
+                unsigned int nwords = chunkWordCount(c);
+                for (unsigned int i = 0; i < nwords; ++i) {
+                    uint64_t bits = cw[i];
+                    while (bits) {
+                        f((int)(((c << CHUNK_SHIFT) | (i << 6)) + lowestBit(bits)));
+                        bits &= bits - 1;
+                    }
+                }
+            }
+        }
+
+        // copy the members (internal ids) into an intset_t
+        void toIntset(intset_t &out) const;
+
+    private:
+        static const unsigned int CHUNK_SHIFT = 12;
+        static const unsigned int CHUNK_WORDS = 1 << (CHUNK_SHIFT - 6);
+
+        // dense: words[n >> 6]. chunked: words[chunkOffsets[n >> CHUNK_SHIFT] + ((n >> 6) & (CHUNK_WORDS - 1))]
+        std::vector<uint64_t> words;
+        // word offset of each chunk in words, -1 if not allocated yet. unused when dense
+        intvector_t chunkOffsets;
+        bool chunked;
+        int universe;
+        int members;
+
+        const uint64_t *word(int n) const {
+            if (!chunked) {
+                return &words[n >> 6];
+            }
+            int off = chunkOffsets[n >> CHUNK_SHIFT];
+            return (off < 0) ? NULL : &words[off + ((n >> 6) & (CHUNK_WORDS - 1))];
+        }
+        uint64_t *wordAlloc(int n);
+
+        unsigned int chunkCount() const;
+        unsigned int chunkWordCount(unsigned int c) const;
+        const uint64_t *chunkWords(unsigned int c) const;
+        uint64_t *chunkWords(unsigned int c);
+
+        static unsigned int lowestBit(uint64_t bits);
+        static int popcount(uint64_t bits);
+    };
+
+    // sets larger than this use the chunked bitset layout
+    const int NODESET_DENSE_LIMIT = 1 << 16;
+
+    // traversal templates over a FrozenGraph. the direction policy picks the edges
+    // to follow, the filter which nodes may be entered at all, and the visitors are
+    // called as nodes are reached, so every algorithm gets its own inlined loop
+    // without copying or reversing the graph.
+
+    // direction policies
+    struct SuccDir {
+        static const int *begin(const FrozenGraph &g, int n) { return g.succBegin(n); }
+        static const int *end(const FrozenGraph &g, int n) { return g.succEnd(n); }
+    };
+    struct PredDir {
+        static const int *begin(const FrozenGraph &g, int n) { return g.predBegin(n); }
+        static const int *end(const FrozenGraph &g, int n) { return g.predEnd(n); }
+    };
+
+    // node filters
+    struct AllNodes {
+        bool allow(int) const { return true; }
+    };
+    // keeps out the members of a set, e.g. the sentries
+    struct SkipNodes {
+        explicit SkipNodes(const NodeSet &s) : blocked(s) { }
+        bool allow(int n) const { return !blocked.has(n); }
+        const NodeSet &blocked;
+    };
+    // keeps out the nodes with any of the mask bits set in a per-node property
+    // bitmask, e.g. the sentries. bits must cover every node
+    struct SkipProps {
+        SkipProps(const std::vector<uint8_t> &bits, uint8_t mask) : bits(bits), mask(mask) { }
+        bool allow(int n) const { return (bits[n] & mask) == 0; }
+        const std::vector<uint8_t> &bits;
+        uint8_t mask;
+    };
+    // stays inside the subgraph induced by a set
+    struct OnlyNodes {
+        explicit OnlyNodes(const NodeSet &s) : members(s) { }
+        bool allow(int n) const { return members.has(n); }
+        const NodeSet &members;
+    };
+
+    // visitor that does nothing
+    struct NoVisit {
+        void operator()(int) const { }
+        void operator()(int, int) const { }
+    };
+
+    // visits every node reachable from the nodes on stack, in no particular order.
+    // nodes already in seen or rejected by filter aren't entered, the others are
+    // added to seen and passed to visit(n). nodes are marked when they are queued,
+    // so each one is pushed once. stack is used as the worklist and ends up empty.
+    // returns the number of nodes added to seen
+    template <typename Dir, typename Filter, typename Visit>
+    int walk(const FrozenGraph &g, intvector_t &stack, NodeSet &seen, const Filter &filter, Visit visit) {
+        int added = 0;
+        // filter the start nodes in place, marking the ones that get entered
+        size_t kept = 0;
+        for (size_t i = 0; i < stack.size(); ++i) {
+            int start = stack[i];
+            if (!filter.allow(start) || !seen.insert(start)) {
+                continue;
+            }
+            stack[kept++] = start;
+            ++added;
+        }
+        stack.resize(kept);
+        while (!stack.empty()) {
+            int anode = stack.back();
+            stack.pop_back();
+            visit(anode);
+            for (const int *it = Dir::begin(g, anode); it != Dir::end(g, anode); ++it) {
+                int next = *it;
+                if (!filter.allow(next) || !seen.insert(next)) {
+                    continue;
+                }
+                stack.push_back(next);
+                ++added;
+            }
+        }
+        return added;
+    }
+
+    // breadth-first version of walk(). queue holds the start nodes, visit(n) is
+    // called in BFS order, which is also the order the nodes are left in queue
+    template <typename Dir, typename Filter, typename Visit>
+    int bfs(const FrozenGraph &g, intvector_t &queue, NodeSet &seen, const Filter &filter, Visit visit) {
+        size_t kept = 0;
+        for (size_t i = 0; i < queue.size(); ++i) {
+            int start = queue[i];
+            if (filter.allow(start) && seen.insert(start)) {
+                queue[kept++] = start;
+            }
+        }
+        queue.resize(kept);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int anode = queue[head];
+            visit(anode);
+            for (const int *it = Dir::begin(g, anode); it != Dir::end(g, anode); ++it) {
+                int next = *it;
+                if (filter.allow(next) && seen.insert(next)) {
+                    queue.push_back(next);
+                }
+            }
+        }
+        return (int)queue.size();
+    }
+
+    // (node, next edge) pairs of a depth-first search in progress
+    typedef std::vector<std::pair<int, const int *> > dfsStack_t;
+
+    // proper depth-first search from start. discover(n, parent) is called in
+    // preorder, with parent -1 for start, and finish(n) in postorder. same seen and
+    // filter rules as walk(). stack is scratch space so repeated calls don't allocate
+    template <typename Dir, typename Filter, typename Discover, typename Finish>
+    void dfs(const FrozenGraph &g, int start, dfsStack_t &stack, NodeSet &seen, const Filter &filter,
+             Discover discover, Finish finish) {
+        if (!filter.allow(start) || !seen.insert(start)) {
+            return;
+        }
+        discover(start, -1);
+        stack.clear();
+        stack.push_back(std::make_pair(start, Dir::begin(g, start)));
+        while (!stack.empty()) {
+            std::pair<int, const int *> &top = stack.back();
+            int anode = top.first;
+            if (top.second == Dir::end(g, anode)) {
+                stack.pop_back();
+                finish(anode);
+                continue;
+            }
+            int next = *top.second++;
+            if (!filter.allow(next) || !seen.insert(next)) {
+                continue;
+            }
+            discover(next, anode);
+            stack.push_back(std::make_pair(next, Dir::begin(g, next)));
+        }
+    }
+
     // some convenience functions to check existence of nodes in data structures
     bool intsetHas(const intset_t &s1, int n1);
     bool intdequeHas(const intdeque_t &s1, int n1);
@@ -98,6 +498,246 @@ namespace Flare {
 #define NODE_COLOR_ROOT "green"
 #define NODE_COLOR_SENTRY "firebrick1"
 
+    // an analysis result memoized by FlareGraph, tagged with the mutation generation
+    // it was computed for. generations start at 1, so a stamp of 0 is never current
+    template <typename T>
+    struct CachedResult {
+        unsigned int stamp;
+        T value;
+
+        CachedResult() : stamp(0) { }
+        bool valid(unsigned int generation) const { return stamp == generation; }
+    };
+
+    // nested simple subgraphs, as found by FlareGraph::findRegionTree(). a region
+    // <n1,n2> is n1's dominator subtree minus n2's subtree, plus n2 itself. with the
+    // nodes laid out in dominator-tree preorder, that's one range with a hole in it,
+    // so a region's full node set is a view over that layout and the whole tree is
+    // O(V) no matter how deeply the regions nest. nodes are public names
+    class RegionTree {
+    public:
+        struct region_t {
+            int n1;
+            int n2;
+            // index of the enclosing region, -1 for top-level regions
+            int parent;
+            // 0 for top-level regions
+            int depth;
+            // preorder range of n1's subtree, and the hole left by n2's subtree
+            int first;
+            int last;
+            int holeFirst;
+            int holeLast;
+        };
+
+        RegionTree() { clear(); }
+
+        void clear();
+
+        // regions are indexed in dominator-tree preorder of n1, so a parent always
+        // comes before its children
+        int size() const { return (int)regions.size(); }
+        const region_t &region(int r) const { return regions[r]; }
+
+        // direct children of region r. r = -1 gives the top-level regions
+        const int *childBegin(int r) const { return childList.data() + childOffsets[r + 1]; }
+        const int *childEnd(int r) const { return childList.data() + childOffsets[r + 2]; }
+
+        // nodes of region r that aren't in any of its children. a node is only ever
+        // in the own set of the innermost regions holding it, which is two regions
+        // at most (the exit of one region that is the entry of the next)
+        const int *ownBegin(int r) const { return ownList.data() + ownOffsets[r]; }
+        const int *ownEnd(int r) const { return ownList.data() + ownOffsets[r + 1]; }
+
+        // size of and membership in the full node set of region r
+        int nodeCount(int r) const;
+        bool contains(int r, int node) const;
+
+        // calls f(node) for every node of region r, including those of its children
+        template <typename F>
+        void forEachNode(int r, F f) const {
+            const region_t &reg = regions[r];
+            for (int i = reg.first; i < reg.holeFirst; ++i) {
+                f(order[i]);
+            }
+            f(reg.n2);
+            for (int i = reg.holeLast; i < reg.last; ++i) {
+                f(order[i]);
+            }
+        }
+
+        // copy the full node set of region r, as in subgraph_t
+        void getNodes(int r, intset_t &out) const;
+
+    private:
+        friend class FlareGraph;
+
+        std::vector<region_t> regions;
+        // CSR lists. childOffsets is shifted by one so the top level can be r = -1
+        intvector_t childOffsets;
+        intvector_t childList;
+        intvector_t ownOffsets;
+        intvector_t ownList;
+        // public names of the reachable nodes in dominator-tree preorder
+        intvector_t order;
+        // public name -> index in order
+        NodeNameTable position;
+    };
+
+    // one group of a plan from FlareGraph::planSimplification(). groups only refer
+    // to groups that come before them in the plan, so applying a plan in order
+    // always collapses inner groups first. nodes are public names
+    struct collapse_t {
+        int n1;
+        int n2;
+        // nodes of region <n1,n2> that aren't already inside an earlier group
+        intvector_t nodes;
+        // plan indexes of the earlier groups this group takes in
+        intvector_t groups;
+        // generated group text
+        std::string label;
+        // visible node count once this group (and every one before it) is collapsed
+        int visibleNodes;
+    };
+    typedef std::vector<collapse_t> collapsePlan_t;
+
+    // a dominator (or post-dominator) tree numbered in preorder, so the subtree of
+    // a node is the interval [pre[a], last[a]) of order. that makes "a dominates b"
+    // two compares, and the number of nodes a dominates is the interval length.
+    // names are internal; the virtual root joining the entries (or exits) is
+    // nodeCount and comes first in order. nodes no root reaches have pre -1
+    struct DominanceIndex {
+        // tree parent of every node, -1 for the virtual root and unreached nodes
+        intvector_t parent;
+        intvector_t depth;
+        intvector_t order;
+        intvector_t pre;
+        intvector_t last;
+
+        int root() const { return (int)parent.size() - 1; }
+        bool reached(int n) const { return pre[n] >= 0; }
+        // a node dominates itself
+        bool dominates(int a, int b) const { return (pre[a] >= 0) && (pre[b] >= pre[a]) && (pre[b] < last[a]); }
+        int subtreeSize(int a) const { return (pre[a] < 0) ? 0 : last[a] - pre[a]; }
+    };
+
+    // sparse table over the preorder of a DominanceIndex, for O(1) lowest common
+    // ancestor queries. level j holds, for every position i, the position of the
+    // shallowest node in [i, i + 2^j). the lca of two nodes is the parent of the
+    // shallowest node after the first of them, up to the second
+    struct LcaTable {
+        // floorLog[len] is the level that covers a range of len positions in two lookups
+        intvector_t floorLog;
+        // level j starts at j * order.size()
+        intvector_t levels;
+    };
+
+    // loop nesting forest, as found by FlareGraph::findLoopForest(). loops are
+    // indexed in preorder of the forest, and each node is stored once under its
+    // innermost loop, so all nodes of loop l (nested loops included) are one
+    // contiguous slice of the body list. nodes are public names
+    class LoopForest {
+    public:
+        struct loop_t {
+            int header;
+            // index of the enclosing loop, -1 for outermost loops
+            int parent;
+            // 0 for outermost loops
+            int depth;
+            // one past the last loop nested inside this one
+            int last;
+            // false if the body can be entered other than through the header
+            bool reducible;
+        };
+
+        LoopForest() { clear(); }
+
+        void clear();
+
+        int size() const { return (int)loops.size(); }
+        const loop_t &loop(int l) const { return loops[l]; }
+
+        // directly nested loops of l. l = -1 gives the outermost loops
+        const int *childBegin(int l) const { return childList.data() + childOffsets[l + 1]; }
+        const int *childEnd(int l) const { return childList.data() + childOffsets[l + 2]; }
+
+        // nodes whose innermost loop is l, header first
+        const int *bodyBegin(int l) const { return bodyList.data() + bodyOffsets[l]; }
+        const int *bodyEnd(int l) const { return bodyList.data() + bodyOffsets[l + 1]; }
+
+        // every node of l, including those of nested loops
+        const int *nodesBegin(int l) const { return bodyList.data() + bodyOffsets[l]; }
+        const int *nodesEnd(int l) const { return bodyList.data() + bodyOffsets[loops[l].last]; }
+        int nodeCount(int l) const { return bodyOffsets[loops[l].last] - bodyOffsets[l]; }
+
+        // innermost loop holding node, -1 if the node isn't in any loop
+        int loopOf(int node) const { return innermost.find(node); }
+        bool contains(int l, int node) const;
+
+        void getNodes(int l, intset_t &out) const;
+
+    private:
+        friend class FlareGraph;
+
+        std::vector<loop_t> loops;
+        // CSR lists. childOffsets is shifted by one so the top level can be l = -1
+        intvector_t childOffsets;
+        intvector_t childList;
+        intvector_t bodyOffsets;
+        intvector_t bodyList;
+        // public name -> innermost loop
+        NodeNameTable innermost;
+    };
+
+    // the nodes, edges, names and block areas of a FlareGraph. a graph shares its
+    // structure with the graphs loaded from it and with its snapshots. a shared
+    // structure is never written to: a graph that isn't its only owner copies it
+    // before changing it, or before freezing it. snapshots are always frozen, so
+    // graphs loaded from one can run their analyses without copying anything
+    class GraphStructure {
+    public:
+        GraphStructure() : isFrozen(false), identityNames(true), edgeCount(0) { }
+
+        int getNodeCount() const { return (int)succs.size(); }
+        int getEdgeCount() const { return edgeCount; }
+
+        // CSR adjacency over the internal names, only valid when frozen
+        bool frozenValid() const { return isFrozen; }
+        const FrozenGraph &getFrozenGraph() const { return frozenGraph; }
+
+    private:
+        friend class FlareGraph;
+
+        // vectors of vectors of ints, tracks the predecessors and successors of each node.
+        // this is the mutable builder representation used by addNode/addEdge
+        array_of_intvector_t preds;
+        array_of_intvector_t succs;
+
+        // packed CSR copy of preds/succs used by the graph algorithms. only valid
+        // while isFrozen is set; any structural change drops it again
+        FrozenGraph frozenGraph;
+        bool isFrozen;
+
+        // keep track of the the area_t for each node
+        areaVec_t blocks;
+
+        // set while every public name equals its internal name, which is always the
+        // case for graphs built from IDA's qflow_chart_t. mapNode/reverseMapNode are
+        // then just a bounds check, and nameMap/reverseNameMap are left empty
+        bool identityNames;
+
+        // map the external node name to the one we use internally
+        NodeNameTable nameMap;
+
+        // map the internal node name to the external one
+        intvector_t reverseNameMap;
+
+        int edgeCount;
+    };
+
+    // immutable handle on a graph's structure, see FlareGraph::snapshot()
+    typedef std::shared_ptr<const GraphStructure> GraphSnapshot;
+
     // Our own graph implementation, largely mimicking the interface to IDA's qflow_chart_t.
     // Used to store state across IDA callbacks because we can't guarantee we're not using
     // IDA's objects past their lifetime. Also
@@ -111,34 +751,81 @@ namespace Flare {
     class FlareGraph {
 
     private:
-        //prevent creation of copy constructor & move
+        //prevent creation of copy constructor. use load() or snapshot() instead
         FlareGraph(const FlareGraph& other);
         FlareGraph& operator=(const FlareGraph& other);
 
-        // vectors of vectors of ints, tracks the predecessors and successors of each node
-        array_of_intvector_t preds;
-        array_of_intvector_t succs;
-
-        // keep track of the the area_t for each node
-        areaVec_t blocks;
-
-        // map the external node name to the one we use internally
-        intintMap_t nameMap;
-
-        // map the internal node name to the external one
-        intintMap_t reverseNameMap;
-
-        // map the internal node name to a vector of properties
-        std::map<int, nodepropset_t> nodeProps;
-        //
-        // map the internal node name to a raw color. not to be used at the same time as nodeproperties!
-        intstringMap_t nodeColors;
+        // nodes, edges, names and areas, possibly shared (see GraphStructure).
+        // never null. reading is always fine, writing has to go through
+        // ownStructure() or editStructure()
+        std::shared_ptr<GraphStructure> structure;
+
+        // mutation generations for the memoized analyses. structureGen moves on
+        // every node or edge change, rootsGen on those plus any change to the root
+        // or sentry properties. the other node properties don't feed any analysis
+        unsigned int structureGen;
+        unsigned int rootsGen;
+
+        // memoized analyses, indexed by post where there are two directions.
+        // terminals/domTrees/rpo/scc follow structureGen, reach/uniqueReach rootsGen
+        CachedResult<intvector_t> terminalsCache[2];
+        CachedResult<intvector_t> domTreeCache[2];
+        CachedResult<intvector_t> rpoCache;
+        CachedResult<intvector_t> rpoNumberCache;
+        CachedResult<NodeSet> reachCache;
+        CachedResult<NodeSet> uniqueReachCache;
+        CachedResult<intvector_t> sccCache;
+        CachedResult<DominanceIndex> domIndexCache[2];
+        CachedResult<LcaTable> lcaCache[2];
+
+        // what findEnclosingRegion() needs for one set of region limits: exitOf[n1]
+        // is n2 of the region starting at n1 (or -1), and up[v] is the closest
+        // region entry above v whose region holds v without v being past its exit
+        struct EnclosingScan {
+            unsigned int minNodeCount;
+            unsigned int maxNodePercentage;
+            intvector_t exitOf;
+            intvector_t up;
+        };
+        CachedResult<EnclosingScan> enclosingCache;
+
+        // contracted groups (see contractGroup()). groupLink is a union-find forest
+        // over the internal names whose roots are the visible nodes, and a root
+        // stands in for every node of its group. quotientSuccs/quotientPreds hold
+        // the contracted adjacency of the roots, possibly still naming nodes that
+        // have since been contracted; they are mapped through the forest and
+        // compacted when read. contractions keeps every group as it was made
+        // (internal names, group name first), so the forest can be replayed after
+        // an expandGroup() or a change to the graph. groupStamp is the structureGen
+        // the forest was built for, 0 to force a replay
+        intvector_t groupLink;
+        intvector_t groupSizes;
+        std::vector<char> groupRoot;
+        array_of_intvector_t quotientSuccs;
+        array_of_intvector_t quotientPreds;
+        array_of_intvector_t contractions;
+        std::vector<char> groupMarks;
+        int visibleCount;
+        unsigned int groupStamp;
+
+        // per-node attributes as parallel arrays over the internal names, grown to
+        // the node count by sizeNodeAttrsi(). nodePropBits holds one bit per
+        // NodeProperty. nodeColorIds is the raw color, 0 for none, otherwise an
+        // index into colorNames plus one. raw colors are not to be used at the
+        // same time as node properties! the areas are kept with the structure
+        std::vector<uint8_t> nodePropBits;
+        std::vector<uint16_t> nodeColorIds;
+        std::vector<std::string> colorNames;
 
         int rootNode;
         fea_t functionEa;
-        int edgeCount;
+        DomMode domMode;
+        unsigned int threadCount;
         //int nodeCount;
+        // the nodes with the Sentry bit, in no particular order. sentrySlots gives
+        // each one's position in it, so clearing a sentry is a swap with the last
         intvector_t sentryNodes;
+        intvector_t sentrySlots;
         std::string inputPath;
 
         // return the internal node ID given the external name
@@ -154,30 +841,169 @@ namespace Flare {
         int nsucci(int name) const;
         int npredi(int name) const;
 
-        //internal versions of reachable and uniqueReachable, uses internal names
-        bool reachablei(intset_t &out);
-        bool uniqueReachablei(intset_t &out);
+        // returns the CSR adjacency, freezing the graph first if it changed
+        const FrozenGraph &frozen();
+
+        // worklist reused by walkSuccsi() so traversals don't allocate
+        intvector_t walkStack;
+
+        // scratch memory for the subgraph analyses. it holds nothing between
+        // calls, so it isn't moved or swapped with the rest of the graph
+        AnalysisWorkspace workspace;
+
+        // shared traversal kernel for the graph algorithms. walks successors
+        // depth-first from start, adding every node it enters to seen. nodes that
+        // are already in seen are not entered again, and nodes in blocked (if
+        // given) are never entered. nodes are marked in seen when they are queued,
+        // so each node is pushed once and the worklist never needs to be searched.
+        // returns the number of nodes added to seen
+        int walkSuccsi(int start, NodeSet &seen, const NodeSet *blocked);
+        // same, starting from several nodes at once
+        int walkSuccsi(const intvector_t &starts, NodeSet &seen, const NodeSet *blocked);
+        int walkFromStacki(NodeSet &seen, const NodeSet *blocked);
 
-        // TODO
-        //DomGraph initDomGraph();
-        bool idomHelper(DomGraph &dgr, intintMap_t &outdom, int entry);
-        bool verifySimpleSubGraphs(subgraphVec_t &out, intintPairSet_t &candidates, unsigned int minNodeCount, unsigned int maxNodePercentage);
+        //internal versions of reachable and uniqueReachable, uses internal names
+        bool reachablei(NodeSet &out);
+        bool uniqueReachablei(NodeSet &out);
+        // same, from any internal node rather than the root node. not memoized, and
+        // the node properties are left alone
+        void reachableFromi(int root, NodeSet &out);
+        void uniqueReachableFromi(int root, NodeSet &out);
+
+        // semi-NCA dominator computation straight on the CSR arrays. with post set,
+        // edges are followed backwards to get post-dominators. roots are internal
+        // names; with more than one root they hang off a virtual root whose name in
+        // outIdom is getNodeCount(). outIdom[n] is -1 for a single root and for nodes
+        // that can't be reached from the roots
+        void computeDominators(const intvector_t &roots, bool post, intvector_t &outIdom);
+
+        // shared code for the public idom()/ipdom() variants, outIdom uses internal names
+        bool domTreei(int entry, bool post, intvector_t &outIdom);
+
+        // converts an idom array over internal names to one indexed by public name
+        void publicDomVector(const intvector_t &dom, intvector_t &out) const;
+
+        // record a change to the nodes/edges, or to the root/sentry nodes
+        void touchStructure();
+        void touchRoots();
+
+        // grow the per-node attribute arrays to the node count
+        void sizeNodeAttrsi();
+
+        // the structure for writing, copied first if it is shared. editStructure()
+        // is for changes to the nodes or edges: it also unfreezes the graph and
+        // calls touchStructure()
+        GraphStructure &ownStructure();
+        GraphStructure &editStructure();
+
+        // internal names of nodes without successors (post) or without
+        // predecessors (!post). if there are none, one stand-in node for every
+        // closed loop instead. memoized
+        const intvector_t &terminalsi(bool post);
+
+        // dominator tree from a virtual root joined to all of terminalsi(post),
+        // translated to the merged getDomIntMap() values: a node whose idom is the
+        // virtual root is IPDOM_UNKNOWN if it is one of the roots and IPDOM_CONFLICT
+        // otherwise. nodes that can't be reached stay IPDOM_UNKNOWN. uses internal
+        // names and is memoized
+        const intvector_t &mergedDomTreei(bool post);
+
+        // reverse postorder of a DFS from the entries (then from any node the entries
+        // don't reach), and each node's position in it. memoized
+        const intvector_t &rpoi();
+        const intvector_t &rpoNumberi();
+
+        // strongly connected component of every internal name, numbered in the order
+        // Tarjan's algorithm closes them (a component's successors come first).
+        // memoized
+        const intvector_t &scci();
+
+        // the virtual-entry dominator tree (or virtual-exit post-dominator tree)
+        // with its preorder numbering. memoized
+        const DominanceIndex &dominanceIndexi(bool post);
+        // lowest common ancestor of u and v in dominanceIndexi(post), -1 if either one
+        // isn't in the tree. the table behind it is built on first use and memoized
+        const LcaTable &lcaTablei(bool post);
+        int lcai(int u, int v, bool post);
+        const EnclosingScan &enclosingScani(unsigned int minNodeCount, unsigned int maxNodePercentage);
+
+        // contracted groups on internal names. syncGroupsi() replays the
+        // contractions if the graph changed since the forest was built,
+        // findGroupi() returns the visible node standing in for in1, and
+        // contractGroupi() merges visible nodes without recording the contraction
+        void syncGroupsi();
+        int findGroupi(int in1);
+        int contractGroupi(const intvector_t &members);
+        void quotientAdjacencyi(int in1, bool post, intvector_t &out);
+
+        // single-pass replacement for verifySimpleSubGraphs() over the
+        // findSimpleSubGraphs() candidates, using dominanceIndexi(false). exits gets
+        // n2 of every region that passed, in preorder; n1 is n2's tree parent.
+        // temporaries come from ws, which the caller must have a Scope open on
+        void scanSimpleRegions(arenaIntvector_t &exits, unsigned int minNodeCount, unsigned int maxNodePercentage, AnalysisWorkspace &ws);
+        bool findSimpleRegions(subgraphVec_t &out, unsigned int minNodeCount, unsigned int maxNodePercentage, AnalysisWorkspace &ws);
+        // candidates are <n1,n2> public name pairs, sorted
+        bool verifySimpleSubGraphs(subgraphVec_t &out, const arenaIntintPairVec_t &candidates, unsigned int minNodeCount, unsigned int maxNodePercentage, AnalysisWorkspace &ws);
         bool isSimpleSubGraph(int n1, int n2, subgraph_t &outset, unsigned int minNodeCount, unsigned int maxNodePercentage);
+        // the checks behind isSimpleSubGraph(), on internal names and with the
+        // caller's scratch space, so verifySimpleSubGraphs() can run several at
+        // once. only reads the frozen graph, so it must be frozen beforehand. roots
+        // holds the exits and entries no subgraph may swallow. when in1 dominates
+        // in2 in dom, the size limits are checked before anything is walked
+        bool checkSubGraphi(int in1, int in2, const intvector_t &roots, const DominanceIndex &dom, NodeSet &region, intvector_t &stack,
+                            subgraph_t &outgraph, unsigned int minNodeCount, unsigned int maxNodePercentage) const;
 
 
     public:
         FlareGraph();
         virtual ~FlareGraph();
 
+        // moving takes everything over, memoized results included, and leaves other
+        // empty
+        FlareGraph(FlareGraph &&other);
+        FlareGraph &operator=(FlareGraph &&other);
+        void swap(FlareGraph &other);
+
         // write out the current graph edges
         bool log() const;
 
-        // explicit copy, basically
+        // explicit copy, basically. the structure and function ea are taken from
+        // other, everything else is cleared. O(1): the two graphs share the
+        // structure until either one changes its nodes, edges or areas. when other
+        // isn't frozen, the first of them to run an analysis copies the structure
+        // to freeze it, so freeze() graphs that are loaded from often
         bool load(const FlareGraph& other);
 
+        // immutable handle on the current structure. freezes the graph, and from
+        // then on the graph and the snapshot share the structure until the graph
+        // changes it. O(1) unless the graph wasn't frozen yet
+        GraphSnapshot snapshot();
+
+        // start over from a snapshot, as load() does. the function ea is cleared
+        bool load(const GraphSnapshot &snap);
+
         // reset the graph to an empty state
         bool clear();
 
+        // pack the current adjacency into the CSR FrozenGraph used by the analysis
+        // functions. called automatically by the algorithms when needed, but can be
+        // called up front once the graph is built. adding nodes or edges afterwards
+        // is still allowed and simply unfreezes the graph
+        bool freeze();
+
+        // true if the CSR adjacency is current with the builder adjacency
+        bool frozenValid() const { return structure->isFrozen; }
+
+        // mutation generations behind the memoized analyses. the structure one
+        // changes with every added node or edge, the roots one also when the root or
+        // a sentry node changes. callers can compare them to tell if results they
+        // kept around are stale
+        unsigned int getStructureGeneration() const { return structureGen; }
+        unsigned int getRootsGeneration() const { return rootsGen; }
+
+        // access the CSR adjacency (internal node names), freezing first if needed
+        const FrozenGraph &getFrozenGraph() { return frozen(); }
+
         // keep track of the associated filepath (like the idb path) for debugging/.dot file inclusion
         bool setFilePath(const char*);
 
@@ -201,7 +1027,7 @@ namespace Flare {
         int getNodeCount() const;
 
         // Get the number of edges in this graph
-        int getEdgeCount() const { return edgeCount; }
+        int getEdgeCount() const { return structure->edgeCount; }
 
         // Get the root node for this graph (if any).
         int getRootNode() const { return reverseMapNode(rootNode); }
@@ -210,7 +1036,7 @@ namespace Flare {
         int getSentryCount() const { return (int)sentryNodes.size(); }
 
         // Get the idx'th sentry node
-        int getSentry(int idx) const { return mapNode(sentryNodes[idx]); }
+        int getSentry(int idx) const { return reverseMapNode(sentryNodes[idx]); }
 
         // Get the area associated with a node (start/stop range)
         bool getNodeArea(int n1, area_t &area) const;
@@ -222,9 +1048,11 @@ namespace Flare {
         // apply a node color
         bool colorNode(int n1, const char* color);
 
-        // Add and clear properties for a given node
+        // Add, clear and test properties for a given node. a graph has at most one
+        // Root, so adding it to a node takes it from the previous root
         bool clearNodeProp(int n1, NodeProperty prop);
         bool addNodeProp(int n1, NodeProperty prop);
+        bool hasNodeProp(int n1, NodeProperty prop) const;
 
         // returns True if an edge n1->n2 exists (n2 is in n1's successor set)
         bool hasSucc(int n1, int n2) const;
@@ -232,7 +1060,6 @@ namespace Flare {
         // returns True if an edge n1->2 exists (n1 in n2's predecessor set)
         bool hasPred(int n1, int n2) const;
 
-        // orange TODO: add DFS visitor helper
         // orange TODO: add graphviz load
 
         // load & store .dot file (with our own format extensions abusing colors for properties
@@ -252,6 +1079,21 @@ namespace Flare {
         // names previously add
         bool addEdge(int n1, int n2);
 
+        // bulk versions of addNode()/addEdge() for loading whole graphs. addNodes()
+        // adds the names that aren't in the graph yet, in order. addEdges() adds
+        // sources[i] -> targets[i] for every i, in order, silently dropping edges
+        // that are already in the graph or repeated in the list. duplicates are
+        // found by bucketing the new edges by source, so the whole batch costs
+        // O(V + E) instead of two linear scans per edge. if any name is bad (or for
+        // addEdges() isn't in the graph) nothing is added and false is returned
+        bool addNodes(const intvector_t &names);
+        bool addEdges(const intvector_t &sources, const intvector_t &targets);
+        bool addEdges(const std::vector<intintPair_t> &edges);
+
+        // replace the graph with nodeCount nodes named 0..nodeCount-1 and the given
+        // edges, as clear() followed by addNodes()/addEdges()
+        bool build(int nodeCount, const intvector_t &sources, const intvector_t &targets);
+
         // TODO: allow string names as well
         //bool addNode(const std::string &name);
         //bool addEdge(const std::string &n1, const std::string &n2);
@@ -263,6 +1105,11 @@ namespace Flare {
         // returns the set of nodes uniquely-reachable from the currently set root node
         bool uniqueReachable(intset_t &out);
 
+        // unique-reachable sets for every successor of dispatcher (e.g. the cases
+        // of a switch), keyed by successor. same result as making each successor
+        // the root and calling uniqueReachable(), but computed in one pass
+        bool uniqueReachableCases(int dispatcher, intsetMap_t &out);
+
         // returns the immediate dominator tree as an int-int map
         // output nodes are the public names
         bool idom(intintMap_t &out, int entry);
@@ -272,6 +1119,16 @@ namespace Flare {
         // node in the normal group.
         bool ipdom(intintMap_t &outdom, int entry);
 
+        // compact versions of idom()/ipdom(): out is indexed by public node name and
+        // holds the immediate (post)dominator, or -1 for entry and unreachable nodes.
+        // names that aren't in the graph are also -1. meant for the dense names IDA uses
+        bool idom(intvector_t &out, int entry);
+        bool ipdom(intvector_t &out, int entry);
+
+        // public names of all nodes in reverse postorder. the DFS starts from the
+        // nodes without predecessors, then picks up whatever they don't reach
+        bool rpo(intvector_t &out);
+
         // analyze the graph starting at entry, looking for an immediate
         // postdominator for node entry. returns the set of nodes also postdominated
         // by entry's immediate postdominator
@@ -291,10 +1148,96 @@ namespace Flare {
         // The intintMap_t out contains public names of nodes (not internal)
         bool getDomIntMap(intintMap_t &out, bool doipdom);
 
+        // selects how the dominator analysis handles several entries or terminals.
+        // DomMode::VirtualRoot (the default) builds one tree per direction and gives
+        // the same getDomIntMap()/findSimpleSubGraphs() results as DomMode::PerRoot.
+        // getpdomGroup() differs in that it no longer fails when entry can't reach
+        // one of the terminals
+        void setDomMode(DomMode mode) { domMode = mode; }
+        DomMode getDomMode() const { return domMode; }
+
+        // number of threads the DomMode::PerRoot candidate checks may use. 0 (the
+        // default) means one per core. the subgraphs come out in the same order
+        // whatever the count
+        void setThreadCount(unsigned int count) { threadCount = count; }
+        unsigned int getThreadCount() const { return threadCount; }
+
 
         // top-level function to find isolated subgraphs of the current graph with
         // the given min/max parameters.
         bool findSimpleSubGraphs(subgraphVec_t &out, unsigned int minNodeCount, unsigned int maxNodePercentage);
+        // same, taking the temporaries from the caller's workspace instead of the
+        // graph's own, e.g. to share one between graphs. once the workspace has
+        // grown to fit, repeated calls only allocate for out. DomMode::PerRoot
+        // still builds its per-terminal dominator maps on the heap
+        bool findSimpleSubGraphs(subgraphVec_t &out, unsigned int minNodeCount, unsigned int maxNodePercentage, AnalysisWorkspace &workspace);
+
+        // true if every path from the entries to b passes through a (with post set,
+        // every path from b to the exits). a node dominates itself. false for names
+        // that aren't in the graph. O(1) once the tree is built
+        bool dominates(int a, int b, bool post);
+        // number of nodes a dominates (or post-dominates), a included. 0 for names
+        // that aren't in the graph
+        int dominatedCount(int a, bool post);
+
+        // the smallest of the findSimpleSubGraphs() subgraphs (with the same limits)
+        // that holds every node of nodes. returns false if none does. after the
+        // first query for a set of limits, each one costs O(nodes.size()) plus the
+        // size of out: the candidates hang off the common dominator and common
+        // post-dominator of nodes, which come from two lca lookups
+        bool findEnclosingRegion(const intset_t &nodes, subgraph_t &out, unsigned int minNodeCount, unsigned int maxNodePercentage);
+
+        // the same subgraphs as findSimpleSubGraphs(), nested into a tree instead of
+        // each one carrying a copy of its nodes. always uses the single-pass dominator
+        // trees, whatever the DomMode
+        bool findRegionTree(RegionTree &out, unsigned int minNodeCount, unsigned int maxNodePercentage);
+
+        // greedy plan to collapse findRegionTree() regions until no more than
+        // targetNodeCount nodes are left visible. regions are taken smallest first,
+        // so a group never holds a region that is collapsed later, and a region is
+        // passed over if it shares its entry or exit with a group that doesn't nest
+        // with it. if the target can't be reached, the plan holds every region that
+        // fits. O(V log V) on top of findRegionTree()
+        bool planSimplification(collapsePlan_t &out, int targetNodeCount, unsigned int minNodeCount, unsigned int maxNodePercentage);
+
+        // contracted groups, the FlareGraph side of IDA's node groups. a group is
+        // named by the first node it was made from, and that name is the visible
+        // node standing in for the whole group until it's contracted into a bigger
+        // one. members must all be visible: nodes that aren't in a group, or the
+        // names of groups that aren't nested in another one. contracting is a
+        // union-find merge plus the members' contracted edges, so it costs the
+        // group's visible size and boundary edges, and groupOf() is close to O(1).
+        // the first call builds the forest in O(V + E). returns the group name, -1
+        // if members is empty or names an unknown or hidden node
+        int contractGroup(const intvector_t &members);
+        // undo the contraction that made the outermost group holding name, so its
+        // members are visible again. false if name isn't in a group. replays the
+        // remaining contractions, O(V + E) plus their sizes
+        bool expandGroup(int name);
+        void clearGroups();
+        // visible node standing in for name: its outermost group, or name itself
+        // if it isn't in one. -1 for names that aren't in the graph
+        int groupOf(int name);
+        bool isGrouped(int name);
+        // number of graph nodes behind the visible node name
+        int groupNodeCount(int name);
+        int getVisibleCount();
+        // visible nodes, in internal name order
+        bool visibleNodes(intvector_t &out);
+        // distinct visible successors (or predecessors) of name's visible node,
+        // without name's visible node itself
+        bool visibleSuccs(int name, intvector_t &out);
+        bool visiblePreds(int name, intvector_t &out);
+
+        // strongly connected components. out is indexed by public node name and holds
+        // the component number, -1 for names that aren't in the graph. components are
+        // numbered in reverse topological order. returns the number of components
+        int stronglyConnectedComponents(intvector_t &out);
+
+        // Havlak's loop nesting forest. the DFS starts from the nodes without
+        // predecessors, then picks up whatever they don't reach, so functions that
+        // never return still get their loops
+        bool findLoopForest(LoopForest &out);
     };
 };
 
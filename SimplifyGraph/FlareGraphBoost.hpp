@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2017 FireEye, Inc. All Rights Reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// Boost Graph Library adapter for FlareGraph. Flare::FrozenGraph models
+// IncidenceGraph, BidirectionalGraph, AdjacencyGraph, VertexListGraph and
+// EdgeListGraph straight on its CSR arrays, so Boost algorithms can run on
+// FlareGraph::getFrozenGraph() without copying into an adjacency_list.
+// vertices are the internal node names 0..nodeCount()-1, which are also their
+// vertex_index. boost::reverse_graph over a FrozenGraph gives the reversed view,
+// again without a copy. the graph must not change while an algorithm runs on it:
+// any addNode()/addEdge() drops the frozen arrays.
+//
+//   const Flare::FrozenGraph &g = fg.getFrozenGraph();
+//   std::vector<int> comp(g.nodeCount());
+//   boost::strong_components(g, boost::make_iterator_property_map(comp.begin(), get(boost::vertex_index, g)));
+
+#ifndef FLARE_GRAPH_BOOST
+#define FLARE_GRAPH_BOOST
+
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/graph/reverse_graph.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/property_map/property_map.hpp>
+
+#include "FlareGraph.hpp"
+
+namespace Flare {
+
+    // an edge of a FrozenGraph. there are no parallel edges, so the two ends are
+    // all it takes to tell edges apart
+    struct FrozenEdge {
+        int source;
+        int target;
+
+        FrozenEdge() : source(-1), target(-1) { }
+        FrozenEdge(int source, int target) : source(source), target(target) { }
+
+        bool operator==(const FrozenEdge &other) const { return (source == other.source) && (target == other.target); }
+        bool operator!=(const FrozenEdge &other) const { return !(*this == other); }
+        bool operator<(const FrozenEdge &other) const {
+            return (source < other.source) || ((source == other.source) && (target < other.target));
+        }
+    };
+
+    // walks one node's slice of succTargets (or predTargets with In set) and makes
+    // the edges on the fly. node is the source of out edges and the target of in edges
+    template <bool In>
+    class FrozenIncidentIterator : public boost::iterator_facade<FrozenIncidentIterator<In>, FrozenEdge,
+                                                                 boost::random_access_traversal_tag, FrozenEdge> {
+    public:
+        FrozenIncidentIterator() : node(-1), pos(NULL) { }
+        FrozenIncidentIterator(int node, const int *pos) : node(node), pos(pos) { }
+
+    private:
+        friend class boost::iterator_core_access;
+
+        FrozenEdge dereference() const { return In ? FrozenEdge(*pos, node) : FrozenEdge(node, *pos); }
+        bool equal(const FrozenIncidentIterator &other) const { return pos == other.pos; }
+        void increment() { ++pos; }
+        void decrement() { --pos; }
+        void advance(std::ptrdiff_t n) { pos += n; }
+        std::ptrdiff_t distance_to(const FrozenIncidentIterator &other) const { return other.pos - pos; }
+
+        int node;
+        const int *pos;
+    };
+
+    // every edge in succTargets order, i.e. grouped by source
+    class FrozenEdgeIterator : public boost::iterator_facade<FrozenEdgeIterator, FrozenEdge,
+                                                             boost::forward_traversal_tag, FrozenEdge> {
+    public:
+        FrozenEdgeIterator() : graph(NULL), node(0), pos(0) { }
+        FrozenEdgeIterator(const FrozenGraph *graph, int pos) : graph(graph), node(0), pos(pos) { skipEmpty(); }
+
+    private:
+        friend class boost::iterator_core_access;
+
+        FrozenEdge dereference() const { return FrozenEdge(node, graph->succTargets[pos]); }
+        bool equal(const FrozenEdgeIterator &other) const { return pos == other.pos; }
+        void increment() { ++pos; skipEmpty(); }
+
+        // move node up to the source of pos
+        void skipEmpty() {
+            int count = graph->nodeCount();
+            while ((node < count) && (pos >= graph->succOffsets[node + 1])) {
+                ++node;
+            }
+        }
+
+        const FrozenGraph *graph;
+        int node;
+        int pos;
+    };
+
+}
+
+namespace boost {
+
+    template <>
+    struct graph_traits<Flare::FrozenGraph> {
+        typedef int vertex_descriptor;
+        typedef Flare::FrozenEdge edge_descriptor;
+        typedef directed_tag directed_category;
+        typedef disallow_parallel_edge_tag edge_parallel_category;
+        struct traversal_category : public bidirectional_graph_tag, public adjacency_graph_tag,
+                                    public vertex_list_graph_tag, public edge_list_graph_tag { };
+
+        typedef Flare::FrozenIncidentIterator<false> out_edge_iterator;
+        typedef Flare::FrozenIncidentIterator<true> in_edge_iterator;
+        typedef const int *adjacency_iterator;
+        typedef boost::counting_iterator<int> vertex_iterator;
+        typedef Flare::FrozenEdgeIterator edge_iterator;
+
+        // unsigned, as some algorithms (the dominator tree one) count up from the
+        // maximum value and rely on it wrapping around to 0
+        typedef std::size_t vertices_size_type;
+        typedef std::size_t edges_size_type;
+        typedef std::size_t degree_size_type;
+
+        static vertex_descriptor null_vertex() { return -1; }
+    };
+
+    // vertices are their own index
+    template <>
+    struct property_map<Flare::FrozenGraph, vertex_index_t> {
+        typedef typed_identity_property_map<int> type;
+        typedef typed_identity_property_map<int> const_type;
+    };
+
+}
+
+namespace Flare {
+
+    // the free functions the Boost graph concepts ask for, found through ADL
+
+    inline int source(const FrozenEdge &e, const FrozenGraph &) { return e.source; }
+    inline int target(const FrozenEdge &e, const FrozenGraph &) { return e.target; }
+
+    inline std::pair<FrozenIncidentIterator<false>, FrozenIncidentIterator<false> > out_edges(int v, const FrozenGraph &g) {
+        return std::make_pair(FrozenIncidentIterator<false>(v, g.succBegin(v)), FrozenIncidentIterator<false>(v, g.succEnd(v)));
+    }
+    inline std::size_t out_degree(int v, const FrozenGraph &g) { return g.nsucc(v); }
+
+    inline std::pair<FrozenIncidentIterator<true>, FrozenIncidentIterator<true> > in_edges(int v, const FrozenGraph &g) {
+        return std::make_pair(FrozenIncidentIterator<true>(v, g.predBegin(v)), FrozenIncidentIterator<true>(v, g.predEnd(v)));
+    }
+    inline std::size_t in_degree(int v, const FrozenGraph &g) { return g.npred(v); }
+    inline std::size_t degree(int v, const FrozenGraph &g) { return g.nsucc(v) + g.npred(v); }
+
+    inline std::pair<const int *, const int *> adjacent_vertices(int v, const FrozenGraph &g) {
+        return std::make_pair(g.succBegin(v), g.succEnd(v));
+    }
+
+    inline std::pair<boost::counting_iterator<int>, boost::counting_iterator<int> > vertices(const FrozenGraph &g) {
+        return std::make_pair(boost::counting_iterator<int>(0), boost::counting_iterator<int>(g.nodeCount()));
+    }
+    inline std::size_t num_vertices(const FrozenGraph &g) { return g.nodeCount(); }
+
+    inline std::pair<FrozenEdgeIterator, FrozenEdgeIterator> edges(const FrozenGraph &g) {
+        return std::make_pair(FrozenEdgeIterator(&g, 0), FrozenEdgeIterator(&g, g.edgeCount()));
+    }
+    inline std::size_t num_edges(const FrozenGraph &g) { return g.edgeCount(); }
+
+    inline boost::typed_identity_property_map<int> get(boost::vertex_index_t, const FrozenGraph &) {
+        return boost::typed_identity_property_map<int>();
+    }
+    inline int get(boost::vertex_index_t, const FrozenGraph &, int v) { return v; }
+
+    typedef boost::reverse_graph<FrozenGraph, const FrozenGraph &> ReversedFrozenGraph;
+
+    // predecessors become successors, for post-dominators and the like
+    inline ReversedFrozenGraph reversed(const FrozenGraph &g) { return ReversedFrozenGraph(g); }
+
+}
+
+#endif //#ifndef FLARE_GRAPH_BOOST
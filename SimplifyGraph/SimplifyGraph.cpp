@@ -63,6 +63,9 @@
 #define ACTION_NAME_COLLAPSE_CURRENT_SUBGRAPH "SimplifyGraph:collapse_current_subgraph"
 #define ACTION_NAME_COMPLEMENT_CURRENT_GRAPH "SimplifyGraph:complement_current_subgraph"
 #define ACTION_NAME_COMPLEMENT_EXPAND_CURRENT_GRAPH "SimplifyGraph:complement_expand_current_subgraph"
+#define ACTION_NAME_COLLAPSE_LOOP "SimplifyGraph:collapse_loop"
+#define ACTION_NAME_COLLAPSE_SELECTION "SimplifyGraph:collapse_selection"
+#define ACTION_NAME_SIMPLIFY_GRAPH "SimplifyGraph:simplify_graph"
 
 #define BUFFSIZE 512
 
@@ -105,7 +108,7 @@ void setupHooksAndActions(void);
 bool collapsePostDomNodes(GraphHelpContext &ctx);
 void printNodeInfo(const GraphHelpContext &ctx, int n, bool doSubgraphs = false) ;
 bool handleSwitchStatementCollapse() ;
-bool handleSwitchCaseCollapse(GraphHelpContext &ctx, Flare::FlareGraph &fg, int node, groups_crinfos_t &newGroups) ;
+bool handleSwitchCaseCollapse(GraphHelpContext &ctx, Flare::FlareGraph &fg, int node, const Flare::intset_t &ureach, groups_crinfos_t &newGroups) ;
 bool loadFlareGraphFromIda(GraphHelpContext &ctx, Flare::FlareGraph &fg, bool orig) ;
 bool fillContext(GraphHelpContext &ctx) ;
 bool createGroup(GraphHelpContext &ctx, Flare::FlareGraph &fg, const Flare::intset_t &group) ;
@@ -115,6 +118,9 @@ bool isValidNewGroup(mutable_graph_t *mgraph, const Flare::FlareGraph &fg, const
 bool updateContext(GraphHelpContext &ctx) ;
 bool complementCurrentSubgraph() ;
 bool complementCurrentGroup() ;
+bool collapseCurrentLoop() ;
+bool collapseSelection() ;
+bool simplifyGraph() ;
 bool isGraphActive() ;
 
 //-------------------------------------------------------------------------
@@ -129,11 +135,14 @@ unsigned int g_maximumSubgraphNodePercentage = 95;
 // g_highLightNodeColor: RGB color value to use when highlighting subgraphs
 unsigned int g_highLightNodeColor = CURRENT_SUBGRAPH_COLOR;
 
+// g_simplifyTargetNodeCount: "Simplify graph" collapses regions until no more than N nodes are visible
+unsigned int g_simplifyTargetNodeCount = 30;
 
 static const cfgopt_t g_opts[] = {
   cfgopt_t("MINIMUM_SUBGRAPH_NODE_COUNT", &g_minimumSubgraphNodeCount),
   cfgopt_t("MAXIMUM_SUBGRAPH_NODE_PERCENTAGE", &g_maximumSubgraphNodePercentage),
   cfgopt_t("SUBGRAPH_HIGHLIGHT_COLOR", &g_highLightNodeColor),
+  cfgopt_t("SIMPLIFY_TARGET_NODE_COUNT", &g_simplifyTargetNodeCount),
 };
 
 //-------------------------------------------------------------------------
@@ -215,7 +224,7 @@ private:
     GraphHelpContext m_ctx;
     Flare::FlareGraph m_fg;
     ColorCacheMap m_colorCache;
-    Flare::subgraphVec_t m_subgraphs;
+    Flare::RegionTree m_regions;
     intvec_t m_currentlySelected;
     size_t m_currentlyHighlightedGroup;
  
@@ -308,7 +317,7 @@ public:
         m_colorCache.restore();
         m_colorCache.clear();
         m_fg.clear();
-        m_subgraphs.clear();
+        m_regions.clear();
         m_currentlySelected.clear();
         m_currentlyHighlightedGroup = INVALID_GROUP_HIGHLIGHT;
         m_fstart = 0;
@@ -319,8 +328,8 @@ public:
     uint32 onGetSize() {
         bool ret = updateContext(m_ctx);
         if (ret) {
-            DEBUGLOG("SubgraphChooser::onGetSize: %d\n", m_subgraphs.size());
-            return m_subgraphs.size();
+            DEBUGLOG("SubgraphChooser::onGetSize: %d\n", m_regions.size());
+            return m_regions.size();
         }
         DEBUGLOG("SubgraphChooser::onGetSize: not an active graph\n");
         clear();
@@ -334,12 +343,13 @@ public:
             qstrncpy(arrptr[1], "StartEA2", MAXSTR);
             qstrncpy(arrptr[2], "Count", MAXSTR);
             qstrncpy(arrptr[3], "Percent", MAXSTR);
+            qstrncpy(arrptr[4], "Depth", MAXSTR);
         } else {
             // reminder: subtract 1 from n to account for title row
             --n;
-            if (n >= m_subgraphs.size())
+            if (n >= (uint32)m_regions.size())
                 return;
-            Flare::subgraph_t &curr = m_subgraphs[n];
+            const Flare::RegionTree::region_t &curr = m_regions.region(n);
             qstring desc;
             Flare::area_t area1, area2;
             bool ret1 = g_lastFlowGraph.getNodeArea(curr.n1, area1);
@@ -351,14 +361,16 @@ public:
                 desc.sprnt("%08" EAFMTSTR, area2.start);
                 qstrncpy(arrptr[1], desc.c_str(), MAXSTR);
             } 
-            desc.sprnt("%d", curr.nodes.size());
+            desc.sprnt("%d", m_regions.nodeCount(n));
             qstrncpy(arrptr[2], desc.c_str(), MAXSTR);
             if(m_fg.getNodeCount() == 0) {
                 desc.sprnt("N/A");
             } else {
-                desc.sprnt("%d", int((double(curr.nodes.size())/m_fg.getNodeCount())*100.0));
+                desc.sprnt("%d", int((double(m_regions.nodeCount(n))/m_fg.getNodeCount())*100.0));
             }
             qstrncpy(arrptr[3], desc.c_str(), MAXSTR);
+            desc.sprnt("%d", curr.depth);
+            qstrncpy(arrptr[4], desc.c_str(), MAXSTR);
         }
     }
 
@@ -430,10 +442,9 @@ public:
         DEBUGLOG("SubgraphChooser::onGetAttrs\n");
         // reminder: subtract 1 from n to account for title row
         --n;
-        if (n >= m_subgraphs.size())
+        if (n >= (uint32)m_regions.size())
             return;
-        Flare::subgraph_t &curr = m_subgraphs[n];
-        if (isValidNewGroup(m_ctx.mgraph, m_fg, curr.nodes)) {
+        if (isValidNewRegion(m_ctx.mgraph, n)) {
             attrs->color = DEFCOLOR;
             attrs->flags = 0;
         } else {
@@ -465,8 +476,8 @@ public:
 
     virtual size_t idaapi get_count() const {
         if (isGraphActive()) {
-            DEBUGLOG("SubgraphChooser::get_count(): %d\n", m_subgraphs.size());
-            return m_subgraphs.size();
+            DEBUGLOG("SubgraphChooser::get_count(): %d\n", m_regions.size());
+            return m_regions.size();
         }
         DEBUGLOG("SubgraphChooser::get_count(): not an active graph\n");
         //clear();
@@ -484,17 +495,17 @@ public:
     }
 
     virtual void idaapi get_row( qstrvec_t *cols_, int *icon_, chooser_item_attrs_t *attrs, size_t n) const {
-        if (n >= m_subgraphs.size())
+        if (n >= (size_t)m_regions.size())
             return;
         if (!isGraphActive()) {
             return;
         }
 
-        const Flare::subgraph_t &curr = m_subgraphs[n];
+        const Flare::RegionTree::region_t &curr = m_regions.region(n);
         Flare::area_t area1, area2;
         qstrvec_t &cols = *cols_;
         DEBUGLOG("Size of cols: %d\n", cols.size());
-        if (cols.size() < 4) {
+        if (cols.size() < 5) {
             LOG("Bailing due to bad cols vector\n");
         }
         bool ret1 = g_lastFlowGraph.getNodeArea(curr.n1, area1);
@@ -504,12 +515,13 @@ public:
             cols[0].sprnt("%08" EAFMTSTR, area1.start);
             cols[1].sprnt("%08" EAFMTSTR, area2.start);
         } 
-        cols[2].sprnt("%d", curr.nodes.size());
+        cols[2].sprnt("%d", m_regions.nodeCount(n));
         if(m_fg.getNodeCount() == 0) {
             cols[3].sprnt("N/A");
         } else {
-            cols[3].sprnt("%d", int((double(curr.nodes.size())/m_fg.getNodeCount())*100.0));
+            cols[3].sprnt("%d", int((double(m_regions.nodeCount(n))/m_fg.getNodeCount())*100.0));
         }
+        cols[4].sprnt("%d", curr.depth);
 
         if(!attrs) {
             LOG("Null attrs pointer\n");
@@ -517,7 +529,7 @@ public:
             DEBUGLOG("Maybe valid attrs pointer. size is %d (vs %d)\n", attrs->cb, sizeof(chooser_item_attrs_t));
             // arrrrgh! const! can't update any of my state
             mutable_graph_t *mgraph = get_viewer_graph(m_ctx.tcontrol);
-            if (isValidNewGroup(mgraph, m_fg, curr.nodes)) {
+            if (isValidNewRegion(mgraph, n)) {
                 DEBUGLOG("No group %d already exists\n", n);
                 attrs->color = DEFCOLOR;
                 attrs->flags = 0;
@@ -591,9 +603,9 @@ public:
     bool commonOnEnter(size_t n) {
         DEBUGLOG("SubgraphChooser::commonOnEnter %d\n", n);
         // adjust for column name row
-        if (n >= m_subgraphs.size())
+        if (n >= (size_t)m_regions.size())
             return false;
-        Flare::subgraph_t &curr = m_subgraphs[n];
+        const Flare::RegionTree::region_t &curr = m_regions.region(n);
         m_currentlyHighlightedGroup = n;
         //reset colors
         func_item_iterator_t fii;
@@ -605,16 +617,15 @@ public:
         }
 
         Flare::area_t area1;
-        for (auto it = curr.nodes.begin(); it != curr.nodes.end(); ++it) {
-            bool ret1 =  g_lastFlowGraph.getNodeArea(*it, area1);
+        m_regions.forEachNode(n, [&](int node) {
+            bool ret1 =  g_lastFlowGraph.getNodeArea(node, area1);
             if (ret1) {
-                DEBUGLOG("Applying color to node %d: %08" EAFMTSTR " - %08" EAFMTSTR "\n", *it, area1.start, area1.end);
+                DEBUGLOG("Applying color to node %d: %08" EAFMTSTR " - %08" EAFMTSTR "\n", node, area1.start, area1.end);
                 colorBlock(area1, g_highLightNodeColor);
             } else {
-                msg("%s: Unable to get node %d area_t\n", PLUGINNAME, *it);
+                msg("%s: Unable to get node %d area_t\n", PLUGINNAME, node);
             }
-
-        }
+        });
         Flare::fea_t jumpea = g_lastFlowGraph.getNodeAreaStart(curr.n1);
         staticClearRefreshChooser(false);
         jumpto(jumpea);
@@ -623,8 +634,13 @@ public:
     }
 
     bool commonOnInsert(ssize_t idx) {
-        DEBUGLOG("%s: Creating group %d of %d\n", PLUGINNAME, idx, m_subgraphs.size());
-        bool ret = createGroup(m_ctx, m_fg, m_subgraphs[idx].nodes);
+        DEBUGLOG("%s: Creating group %d of %d\n", PLUGINNAME, idx, m_regions.size());
+        if ((idx < 0) || (idx >= m_regions.size())) {
+            return false;
+        }
+        Flare::intset_t group;
+        m_regions.getNodes((int)idx, group);
+        bool ret = createGroup(m_ctx, m_fg, group);
         if (ret) {
             DEBUGLOG("Created new group\n");
         } else {
@@ -648,7 +664,7 @@ public:
             // pass
             DEBUGLOG("Skipping redundant subgraph load\n");
         } else {
-            DEBUGLOG("Loading m_subgraphs now\n");
+            DEBUGLOG("Loading m_regions now\n");
             m_fstart = g_lastFlowGraph.getFunctionEa() ;
             loadSubgraphs();
         }
@@ -670,25 +686,37 @@ public:
             return false;
         }
         cacheCurrentFunctionColors();
-        ret = m_fg.findSimpleSubGraphs(m_subgraphs, g_minimumSubgraphNodeCount, g_maximumSubgraphNodePercentage);
+        ret = m_fg.findRegionTree(m_regions, g_minimumSubgraphNodeCount, g_maximumSubgraphNodePercentage);
         if (!ret) {
-            msg("%s: findSimpleSubGraphs failed :(\n", PLUGINNAME);
+            msg("%s: findRegionTree failed :(\n", PLUGINNAME);
             return false;
         }
-        DEBUGLOG("%s: Found %d interesting subgraphs\n", PLUGINNAME, m_subgraphs.size());
+        DEBUGLOG("%s: Found %d interesting subgraphs\n", PLUGINNAME, m_regions.size());
         DEBUGEXEC({
-            for (auto it = m_subgraphs.begin(); it != m_subgraphs.end(); ++it) {
-                DEBUGLOG("Got interesting subgraph %d nodes\n", it->nodes.size());
-                for (auto git = it->nodes.begin(); git != it->nodes.end(); ++git) {
+            for (int r = 0; r < m_regions.size(); ++r) {
+                DEBUGLOG("Got interesting subgraph %d nodes, parent %d\n", m_regions.nodeCount(r), m_regions.region(r).parent);
+                m_regions.forEachNode(r, [&](int node) {
                     Flare::area_t ar1;
-                    g_lastFlowGraph.getNodeArea(*git, ar1);
-                    DEBUGLOG("  %d: %08" EAFMTSTR " - %08" EAFMTSTR "\n", *git, ar1.start, ar1.end);
-                }
+                    g_lastFlowGraph.getNodeArea(node, ar1);
+                    DEBUGLOG("  %d: %08" EAFMTSTR " - %08" EAFMTSTR "\n", node, ar1.start, ar1.end);
+                });
             }
         });
         return true;
     }
 
+    // same as isValidNewGroup(), straight off the region tree's node view
+    bool isValidNewRegion(mutable_graph_t *mgraph, size_t n) const {
+        bool valid = true;
+        m_regions.forEachNode((int)n, [&](int node) {
+            if (valid && mgraph->is_subgraph_node(node)) {
+                DEBUGLOG("isValidNewRegion Node %d is in group %d\n", node, mgraph->get_node_group(node));
+                valid = false;
+            }
+        });
+        return valid;
+    }
+
     void colorBlock(const Flare::area_t &area, bgcolor_t color) {
         ea_t curr = area.start;
         while (curr != area.end) {
@@ -719,8 +747,10 @@ public:
         if (m_currentlyHighlightedGroup == INVALID_GROUP_HIGHLIGHT) {
             return false;
         }
-        msg("Creating group: %d of %d\n", m_currentlyHighlightedGroup, m_subgraphs.size());
-        bool ret = createGroup(m_ctx, m_fg, m_subgraphs[m_currentlyHighlightedGroup].nodes);
+        msg("Creating group: %d of %d\n", m_currentlyHighlightedGroup, m_regions.size());
+        Flare::intset_t group;
+        m_regions.getNodes((int)m_currentlyHighlightedGroup, group);
+        bool ret = createGroup(m_ctx, m_fg, group);
         if (ret) {
             DEBUGLOG("Created new group\n");
         } else {
@@ -738,12 +768,11 @@ public:
             DEBUGLOG("No\n");
             return false;
         }
-        if (m_currentlyHighlightedGroup >= m_subgraphs.size()) {
-            LOG("Bad node to isNodeHighlighted: (curr highligh: %d) vs (subgraphs count: %d)\n", m_currentlyHighlightedGroup, m_subgraphs.size());
+        if (m_currentlyHighlightedGroup >= (size_t)m_regions.size()) {
+            LOG("Bad node to isNodeHighlighted: (curr highligh: %d) vs (subgraphs count: %d)\n", m_currentlyHighlightedGroup, m_regions.size());
             return false;
         }
-        Flare::subgraph_t &curr = m_subgraphs[m_currentlyHighlightedGroup];
-        if (curr.nodes.find(node) == curr.nodes.end()) {
+        if (!m_regions.contains((int)m_currentlyHighlightedGroup, node)) {
             DEBUGLOG("No\n");
             return false;
         }
@@ -864,6 +893,7 @@ const int SubgraphChooser::widths_[] = {
     8, 
     8, 
     4, 
+    4,
     4 
 };
 
@@ -871,7 +901,8 @@ const char *const SubgraphChooser::header_[] = {
     "StartEA1", 
     "StartEA2", 
     "Count",
-    "Percent" 
+    "Percent",
+    "Depth" 
 };
 
 #if IDA_SDK_VERSION < 700
@@ -1221,18 +1252,23 @@ bool loadCurrentFlowChart(qflow_chart_t *fc) {
 
 #endif // #if IDA_SDK_VERSION < 700
 
-    g_lastFlowGraph.setFunctionEa(fc->blocks[0].STARTEA);
+    Flare::intvector_t sources;
+    Flare::intvector_t targets;
     for (int i = 0; i < fc->size(); ++i) {
-        g_lastFlowGraph.addNode(i);
         for (int j = 0; j < fc->nsucc(i); j++) {
-            int succ = fc->succ(i, j);
-            //no penalty for re-adding duplicate nodes. Same names assumed
-            // to be the same node
-            g_lastFlowGraph.addNode(succ);
-            g_lastFlowGraph.addEdge(i, succ);
+            sources.push_back(i);
+            targets.push_back(fc->succ(i, j));
         }
+    }
+    // build() starts from an empty graph, so the function ea goes in after it
+    g_lastFlowGraph.build(fc->size(), sources, targets);
+    g_lastFlowGraph.setFunctionEa(fc->blocks[0].STARTEA);
+    for (int i = 0; i < fc->size(); ++i) {
         g_lastFlowGraph.setNodeArea(i, fc->blocks[i].STARTEA, fc->blocks[i].ENDEA);
     }
+    // every action starts from a load() of this graph, which shares its
+    // structure. freezing it here means none of them have to copy it
+    g_lastFlowGraph.freeze();
     DEBUGEXEC({
         DEBUGLOG("Just loaded FlareGraph\n");
         g_lastFlowGraph.log();
@@ -1261,25 +1297,28 @@ bool loadFlareGraphFromIda(GraphHelpContext &ctx, Flare::FlareGraph &fg, bool or
     int sentryCount = 0;
 
     if (orig) {
-        // load the original flowgraph, stored in g_lastFlowGraph
+        // load the original flowgraph, stored in g_lastFlowGraph. nothing is copied
         fg.load(g_lastFlowGraph);
     } else {
         fg.clear();
         // load the current viewable graph
+        Flare::intvector_t names;
+        Flare::intvector_t sources;
+        Flare::intvector_t targets;
         for (int i = 0; i < ctx.mgraph->size(); ++i) {
             if (ctx.mgraph->is_visible_node(i)) {
-                fg.addNode(i);
+                names.push_back(i);
                 for (int j = 0; j < ctx.mgraph->nsucc(i); j++) {
                     int succ = ctx.mgraph->succ(i, j);
                     if (ctx.mgraph->is_visible_node(succ)) {
-                        //no penalty for re-adding duplicate nodes. Same names assumed
-                        // to be the same node
-                        int newNode = fg.addNode(succ);
-                        fg.addEdge(i, succ);
+                        sources.push_back(i);
+                        targets.push_back(succ);
                     }
                 }
             }
         }
+        fg.addNodes(names);
+        fg.addEdges(sources, targets);
     }
     // now add properties
     screen_graph_selection_t graphSel;
@@ -1418,6 +1457,39 @@ struct ComplementExpandGraphActionHandler : public action_handler_t {
     }
 };
 
+struct LoopActionHandler : public action_handler_t {
+    virtual int idaapi activate(action_activation_ctx_t *) {
+        DEBUGLOG("LoopActionHandler called\n");
+        return collapseCurrentLoop();
+    }
+
+    virtual action_state_t idaapi update(action_update_ctx_t *) {
+        return AST_ENABLE_ALWAYS;
+    }
+};
+
+struct SelectionActionHandler : public action_handler_t {
+    virtual int idaapi activate(action_activation_ctx_t *) {
+        DEBUGLOG("SelectionActionHandler called\n");
+        return collapseSelection();
+    }
+
+    virtual action_state_t idaapi update(action_update_ctx_t *) {
+        return AST_ENABLE_ALWAYS;
+    }
+};
+
+struct SimplifyGraphActionHandler : public action_handler_t {
+    virtual int idaapi activate(action_activation_ctx_t *) {
+        DEBUGLOG("SimplifyGraphActionHandler called\n");
+        return simplifyGraph();
+    }
+
+    virtual action_state_t idaapi update(action_update_ctx_t *) {
+        return AST_ENABLE_ALWAYS;
+    }
+};
+
 struct SwitchCaseActionHandler : public action_handler_t {
     virtual int idaapi activate(action_activation_ctx_t *) {
         DEBUGLOG("SwitchCaseActionHandler called\n");
@@ -1458,6 +1530,9 @@ static CreateSubgraphActionHandler g_sgah;
 static CreateDotFileActionHandler g_dotah;
 static PostDomSubgraphActionHandler g_pdah;
 static SwitchCaseActionHandler g_switchah;
+static LoopActionHandler g_loopah;
+static SelectionActionHandler g_selectionah;
+static SimplifyGraphActionHandler g_simplifyah;
 static DiscoverIsolatedSubgraphsHandler g_discoversubgraphah;
 static CollapseCurrentSubgraphsHandler g_collasepsubgraphah;
 static ComplementGraphActionHandler g_complementsubgraphah;
@@ -1488,6 +1563,9 @@ plugin_t PLUGIN = {
 static const action_desc_t actions[] = {
     ACTION_DESC_LITERAL(ACTION_NAME_COLLAPSE_UNIQUE_REACH, "Create UR group", &g_sgah, NULL, NULL, -1), 
     ACTION_DESC_LITERAL(ACTION_NAME_COLLAPSE_SWITCH_CASES, "Create switch case groups", &g_switchah, NULL, NULL, -1),
+    ACTION_DESC_LITERAL(ACTION_NAME_COLLAPSE_LOOP, "Create loop group", &g_loopah, NULL, NULL, -1),
+    ACTION_DESC_LITERAL(ACTION_NAME_COLLAPSE_SELECTION, "Create group around selection", &g_selectionah, NULL, NULL, -1),
+    ACTION_DESC_LITERAL(ACTION_NAME_SIMPLIFY_GRAPH, "Simplify graph", &g_simplifyah, NULL, NULL, -1),
     ACTION_DESC_LITERAL(ACTION_NAME_DISCOVER_ISOLATED_SUBGRAPHS, "Discover isolated subgraphs", &g_discoversubgraphah, NULL, NULL, -1),
     ACTION_DESC_LITERAL(ACTION_NAME_COLLAPSE_CURRENT_SUBGRAPH, "Create isolated subgraph", &g_collasepsubgraphah, NULL, NULL, -1),
     ACTION_DESC_LITERAL(ACTION_NAME_COMPLEMENT_CURRENT_GRAPH, "Complement group", &g_complementsubgraphah, NULL, NULL, -1),
@@ -1669,6 +1747,13 @@ bool handleSwitchStatementCollapse() {
         msg("%s: No head node selected!\n", PLUGINNAME);
         return false;
     }
+    // the unique-reachable set of every case, in a single pass over the graph
+    Flare::intsetMap_t caseGroups;
+    ret = fg.uniqueReachableCases(ctx.currNode, caseGroups);
+    if (!ret) {
+        msg("%s: Failed to get unique reachable for switch cases\n", PLUGINNAME);
+        return false;
+    }
     groups_crinfos_t newGroups;
     for (int i = 0; i < ctx.mgraph->nsucc(ctx.currNode); ++i) {
         int succ = ctx.mgraph->succ(ctx.currNode, i);
@@ -1676,8 +1761,14 @@ bool handleSwitchStatementCollapse() {
             // skip non visible nodes
             continue;
         }
+        auto git = caseGroups.find(succ);
+        if (git == caseGroups.end()) {
+            // already handled through another edge to the same case
+            continue;
+        }
         DEBUGLOG("%s: Exploring node %d (%d)\n", PLUGINNAME, succ, i);
-        ret = handleSwitchCaseCollapse(ctx, fg, succ, newGroups);
+        ret = handleSwitchCaseCollapse(ctx, fg, succ, git->second, newGroups);
+        caseGroups.erase(git);
         if (!ret) {
             msg("%s: Switch statement bailing out due to case error\n", PLUGINNAME);
             return false;
@@ -1771,18 +1862,8 @@ bool getSwitchCaseText(GraphHelpContext &ctx, Flare::FlareGraph &fg, int node, q
     return true;
 }
 
-// create a new group for an individual switch case
-bool handleSwitchCaseCollapse(GraphHelpContext &ctx, Flare::FlareGraph &fg, int node, groups_crinfos_t &newGroups) {
-    DEBUGLOG("%s: changing root node from %d to %d\n", PLUGINNAME, fg.getRootNode(), node);
-    fg.clearNodeProp(fg.getRootNode(), Flare::NodeProperty::Root);
-    fg.addNodeProp(node, Flare::NodeProperty::Root);
-    Flare::intset_t ureach;
-    //return true;
-    bool ret = fg.uniqueReachable(ureach);
-    if (!ret) {
-        msg("%s: Failed to get unique reachable for switch case \n", PLUGINNAME);
-        return false;
-    }
+// create a new group for an individual switch case, from its unique-reachable set
+bool handleSwitchCaseCollapse(GraphHelpContext &ctx, Flare::FlareGraph &fg, int node, const Flare::intset_t &ureach, groups_crinfos_t &newGroups) {
     if (ureach.size() == 0) {
         // TODO: right now i'm making a group even if there's only 1 node in the UR 
         // switch case. should i check for this?
@@ -1998,6 +2079,169 @@ bool collapseReachableUniqueNodes(GraphHelpContext &ctx) {
     return createGroup(ctx, fg, ureach);
 }
 
+// group the innermost loop holding the current node
+bool collapseCurrentLoop() {
+    GraphHelpContext ctx;
+    bool ret = fillContext(ctx);
+    if (!ret) {
+        return false;
+    }
+    if (ctx.currNode < 0) {
+        msg("%s: Node not selected\n", PLUGINNAME);
+        return false;
+    }
+    Flare::FlareGraph fg;
+    ret = loadFlareGraphFromIda(ctx, fg, false);
+    if (!ret) {
+        msg("%s: Unable to load FlareGraph from IDA\n", PLUGINNAME);
+        return false;
+    }
+    Flare::LoopForest forest;
+    ret = fg.findLoopForest(forest);
+    if (!ret) {
+        msg("%s: Failed to find loops\n", PLUGINNAME);
+        return false;
+    }
+    int loop = forest.loopOf(ctx.currNode);
+    if (loop < 0) {
+        msg("%s: Node %d is not inside a loop\n", PLUGINNAME, ctx.currNode);
+        return false;
+    }
+    if (!forest.loop(loop).reducible) {
+        msg("%s: Loop at node %d has more than one entry\n", PLUGINNAME, forest.loop(loop).header);
+    }
+    Flare::intset_t nodes;
+    forest.getNodes(loop, nodes);
+    DEBUGLOG("%s: Loop at %d, depth %d: %d nodes\n", PLUGINNAME, forest.loop(loop).header, forest.loop(loop).depth, nodes.size());
+    return createGroup(ctx, fg, nodes);
+}
+
+// group the smallest isolated subgraph holding every selected node
+bool collapseSelection() {
+    GraphHelpContext ctx;
+    bool ret = fillContext(ctx);
+    if (!ret) {
+        return false;
+    }
+    screen_graph_selection_t graphSel;
+    ret = viewer_get_selection(ctx.tcontrol, &graphSel);
+    if (!ret) {
+        msg("%s: Failed to get graph selection\n", PLUGINNAME);
+        return false;
+    }
+    Flare::intset_t selected;
+    for (screen_graph_selection_t::const_iterator p = graphSel.begin(); p != graphSel.end(); ++p) {
+        if (p->is_node) {
+            selected.insert(p->node);
+        }
+    }
+    if (selected.size() == 0) {
+        msg("%s: At least one node must be selected\n", PLUGINNAME);
+        return false;
+    }
+    Flare::FlareGraph fg;
+    ret = loadFlareGraphFromIda(ctx, fg, false);
+    if (!ret) {
+        msg("%s: Unable to load FlareGraph from IDA\n", PLUGINNAME);
+        return false;
+    }
+    Flare::subgraph_t region(-1, -1);
+    ret = fg.findEnclosingRegion(selected, region, 0, 100);
+    if (!ret) {
+        msg("%s: No single entry, single exit region holds the %d selected nodes\n", PLUGINNAME, selected.size());
+        return false;
+    }
+    DEBUGLOG("%s: Region <%d,%d> holds the selection: %d nodes\n", PLUGINNAME, region.n1, region.n2, region.nodes.size());
+    return createGroup(ctx, fg, region.nodes);
+}
+
+// plans groups for the isolated subgraphs of the visible graph until no more than
+// g_simplifyTargetNodeCount nodes are left, then creates them one nesting depth
+// at a time. a group can only take in groups IDA has already created, so each
+// batch uses the group nodes returned for the depths before it. if a batch
+// fails, the groups made so far are deleted again
+bool simplifyGraph() {
+    GraphHelpContext ctx;
+    bool ret = fillContext(ctx);
+    if (!ret) {
+        return false;
+    }
+    Flare::FlareGraph fg;
+    ret = loadFlareGraphFromIda(ctx, fg, false);
+    if (!ret) {
+        msg("%s: Unable to load FlareGraph from IDA\n", PLUGINNAME);
+        return false;
+    }
+    // the original blocks give the groups address labels
+    if (g_lastFlowGraph.getFunctionEa() == ctx.mgraph->gid) {
+        for (int i = 0; i < g_lastFlowGraph.getNodeCount(); ++i) {
+            fg.setNodeArea(i, g_lastFlowGraph.getNodeAreaStart(i), g_lastFlowGraph.getNodeAreaEnd(i));
+        }
+    }
+    Flare::collapsePlan_t plan;
+    ret = fg.planSimplification(plan, g_simplifyTargetNodeCount, g_minimumSubgraphNodeCount, g_maximumSubgraphNodePercentage);
+    if (!ret) {
+        msg("%s: Unable to plan the graph simplification\n", PLUGINNAME);
+        return false;
+    }
+    if (plan.size() == 0) {
+        msg("%s: Nothing to collapse, %d nodes visible\n", PLUGINNAME, fg.getNodeCount());
+        return true;
+    }
+
+    // nesting depth of every planned group. plan entries only take in earlier ones
+    Flare::intvector_t depth(plan.size(), 0);
+    int maxDepth = 0;
+    for (size_t i = 0; i < plan.size(); ++i) {
+        for (auto git = plan[i].groups.begin(); git != plan[i].groups.end(); ++git) {
+            depth[i] = (std::max)(depth[i], depth[*git] + 1);
+        }
+        maxDepth = (std::max)(maxDepth, depth[i]);
+    }
+
+    // plan index -> IDA group node, filled in as each depth is created
+    Flare::intvector_t groupNode(plan.size(), -1);
+    intvec_t created;
+    for (int d = 0; d <= maxDepth; ++d) {
+        groups_crinfos_t newGroups;
+        Flare::intvector_t planIndex;
+        for (size_t i = 0; i < plan.size(); ++i) {
+            if (depth[i] != d) {
+                continue;
+            }
+            group_crinfo_t newGroup;
+            for (auto nit = plan[i].nodes.begin(); nit != plan[i].nodes.end(); ++nit) {
+                newGroup.nodes.push_back(*nit);
+            }
+            for (auto git = plan[i].groups.begin(); git != plan[i].groups.end(); ++git) {
+                newGroup.nodes.push_back(groupNode[*git]);
+            }
+            newGroup.text = plan[i].label.c_str();
+            newGroups.push_back(newGroup);
+            planIndex.push_back((int)i);
+        }
+        intvec_t out_group_nodes;
+        ret = viewer_create_groups(ctx.tcontrol, &out_group_nodes, newGroups);
+        if (!ret || (out_group_nodes.size() != planIndex.size())) {
+            msg("%s: Failed to create the %d planned groups at depth %d\n", PLUGINNAME, planIndex.size(), d);
+            for (size_t i = 0; i < out_group_nodes.size(); ++i) {
+                created.push_back(out_group_nodes[i]);
+            }
+            if ((created.size() > 0) && !viewer_delete_groups(ctx.tcontrol, created)) {
+                msg("%s: Failed to delete the %d groups already created\n", PLUGINNAME, created.size());
+            }
+            return false;
+        }
+        for (size_t i = 0; i < planIndex.size(); ++i) {
+            groupNode[planIndex[i]] = out_group_nodes[i];
+            created.push_back(out_group_nodes[i]);
+        }
+        DEBUGLOG("%s: Created %d groups at depth %d\n", PLUGINNAME, planIndex.size(), d);
+    }
+    msg("%s: Created %d groups, %d of %d nodes left visible\n", PLUGINNAME, plan.size(), plan.back().visibleNodes, fg.getNodeCount());
+    return true;
+}
+
 void idaapi runUniqueReachable(void) {
     GraphHelpContext ctx;
     bool ret = fillContext(ctx);
@@ -2181,6 +2425,9 @@ static ssize_t idaapi ui_callback(void * ud, int notification_code, va_list va)
 
                 if ( ( view != NULL ) &&  ( get_view_renderer_type(view) == TCCRT_GRAPH ) ) {
                     attach_action_to_popup(f, p, ACTION_NAME_COLLAPSE_UNIQUE_REACH, POPUPPATH);
+                    attach_action_to_popup(f, p, ACTION_NAME_COLLAPSE_LOOP, POPUPPATH);
+                    attach_action_to_popup(f, p, ACTION_NAME_COLLAPSE_SELECTION, POPUPPATH);
+                    attach_action_to_popup(f, p, ACTION_NAME_SIMPLIFY_GRAPH, POPUPPATH);
                     // no longer allowing straight collapse to post dominator actions. 
                     // now wrapped in the isolated subgraph chooser
                     //attach_action_to_popup(f, p, ACTION_NAME_COLLAPSE_POST_DOM, POPUPPATH);
@@ -35,6 +35,11 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <memory>
+#include <type_traits>
+#include <thread>
+#include <atomic>
+#include <system_error>
 
 
 
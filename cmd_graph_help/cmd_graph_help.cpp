@@ -4,6 +4,7 @@
 #include "stdafx.h"
 #include <fstream>
 #include <sstream>
+#include <chrono>
 
 #include "FlareGraph.hpp"
 
@@ -159,7 +160,7 @@ static const int g_ColorNamesCount = sizeof(g_ColorNames)/sizeof(g_ColorNames[0]
 
 void printUsage(TCHAR* name) {
     printf("Usage: %s <cmd> <input_file> <output_file>\n", name);
-    printf("Where <cmd> is one of UR or PD or CT\n");
+    printf("Where <cmd> is one of UR or PD or CT or PC or SW or EN or SP\n");
 }
 
 void handleCT(TCHAR* ifilename, TCHAR* ofilename) {
@@ -382,6 +383,239 @@ void handlePD(TCHAR* ifilename, TCHAR* ofilename) {
     printf("Done\n");
 }
 
+// times the dominator and post-dominator analysis with the per-root merge and
+// with a virtual entry/exit, and marks up every node where the two disagree
+void handlePC(TCHAR* ifilename, TCHAR* ofilename) {
+    std::ifstream ifile(ifilename);
+
+    if (!ifile) {
+        _tprintf(_T("failed to open input file '%s'\n"), ifilename);
+        return;
+    }
+    Flare::FlareGraph fg;
+    bool ret = fg.loadGraphViz(ifile);
+    ifile.close();
+    if (!ret) {
+        printf("Failed to load dot file\n");
+        return;
+    }
+
+    const Flare::DomMode modes[] = { Flare::DomMode::PerRoot, Flare::DomMode::VirtualRoot };
+    const char* const modeNames[] = { "per-root", "virtual root" };
+    for (int d = 0; d < 2; ++d) {
+        bool doipdom = (d == 0);
+        const char* treeName = doipdom ? "ipdomtree" : "idomtree";
+        Flare::intintMap_t domtree[2];
+        for (int m = 0; m < 2; ++m) {
+            fg.setDomMode(modes[m]);
+            auto start = std::chrono::steady_clock::now();
+            ret = fg.getDomIntMap(domtree[m], doipdom);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (!ret) {
+                printf("getDomIntMap %s failed in %s mode :(\n", treeName, modeNames[m]);
+                return;
+            }
+            printf("%-12s %-9s: %8.3f ms\n", modeNames[m], treeName, ms);
+            if (doipdom && (fg.getRootNode() >= 0)) {
+                Flare::intset_t pdomgroup;
+                ret = fg.getpdomGroup(pdomgroup, fg.getRootNode());
+                printf("%-12s pdomgroup of %d: %s, %d nodes\n", modeNames[m], fg.getRootNode(), ret ? "ok" : "failed", pdomgroup.size());
+            }
+        }
+
+        int mismatches = 0;
+        for (auto it = domtree[0].begin(); it != domtree[0].end(); ++it) {
+            auto vit = domtree[1].find(it->first);
+            int other = (vit == domtree[1].end()) ? Flare::IPDOM_UNKNOWN : vit->second;
+            if (other != it->second) {
+                printf("Mismatch %s[%3d] = %3d vs %3d\n", treeName, it->first, it->second, other);
+                fg.addNodeProp(it->first, Flare::NodeProperty::Selected);
+                ++mismatches;
+            }
+        }
+        printf("%s: %d of %d nodes differ\n", treeName, mismatches, domtree[0].size());
+    }
+
+    std::ostringstream ostringstr;
+    fg.storeGraphViz(ostringstr);
+    FILE *outf = _tfopen(ofilename, _T("w"));
+    std::string outs = ostringstr.str();
+    fwrite(outs.c_str(), 1, outs.size(), outf);
+    fclose(outf);
+    printf("Done\n");
+}
+
+
+// treats the root node as a switch dispatcher and colors the unique-reachable
+// nodes of each of its cases
+void handleSW(TCHAR* ifilename, TCHAR* ofilename) {
+    std::ifstream ifile(ifilename);
+
+    if (!ifile) {
+        _tprintf(_T("failed to open input file '%s'\n"), ifilename);
+        return;
+    }
+    Flare::FlareGraph fg;
+    bool ret = fg.loadGraphViz(ifile);
+    ifile.close();
+    if (!ret) {
+        printf("Failed to load dot file\n");
+        return;
+    }
+    if (fg.getRootNode() < 0) {
+        printf("No root node to use as the switch dispatcher\n");
+        return;
+    }
+    Flare::intsetMap_t cases;
+    auto start = std::chrono::steady_clock::now();
+    ret = fg.uniqueReachableCases(fg.getRootNode(), cases);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!ret) {
+        printf("Failed to get unique reachable for switch cases\n");
+        return;
+    }
+    printf("Got %d cases for dispatcher %d in %.3f ms\n", cases.size(), fg.getRootNode(), ms);
+    for (auto it = cases.begin(); it != cases.end(); ++it) {
+        int colorIdx = rand() % g_ColorNamesCount;
+        printf("Case %3d: %d nodes: %s\n", it->first, it->second.size(), g_ColorNames[colorIdx]);
+        for (auto nit = it->second.begin(); nit != it->second.end(); ++nit) {
+            fg.colorNode(*nit, g_ColorNames[colorIdx]);
+        }
+    }
+
+    std::ostringstream ostringstr;
+    fg.storeGraphViz(ostringstr);
+    FILE *outf = _tfopen(ofilename, _T("w"));
+    std::string outs = ostringstr.str();
+    fwrite(outs.c_str(), 1, outs.size(), outf);
+    fclose(outf);
+    printf("Done\n");
+}
+
+
+// marks up the smallest isolated subgraph holding the root and every sentry node
+void handleEN(TCHAR* ifilename, TCHAR* ofilename) {
+    std::ifstream ifile(ifilename);
+
+    if (!ifile) {
+        _tprintf(_T("failed to open input file '%s'\n"), ifilename);
+        return;
+    }
+    Flare::FlareGraph fg;
+    bool ret = fg.loadGraphViz(ifile);
+    ifile.close();
+    if (!ret) {
+        printf("Failed to load dot file\n");
+        return;
+    }
+    Flare::intset_t selected;
+    if (fg.getRootNode() >= 0) {
+        selected.insert(fg.getRootNode());
+    }
+    for (int i = 0; i < fg.getSentryCount(); ++i) {
+        selected.insert(fg.getSentry(i));
+    }
+    if (selected.size() == 0) {
+        printf("No root or sentry nodes to enclose\n");
+        return;
+    }
+    Flare::subgraph_t region(-1, -1);
+    auto start = std::chrono::steady_clock::now();
+    ret = fg.findEnclosingRegion(selected, region, 0, 100);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!ret) {
+        printf("No simple subgraph holds the %d selected nodes\n", selected.size());
+        return;
+    }
+    printf("Subgraph <%d,%d> holds the %d selected nodes: %d nodes in %.3f ms\n", region.n1, region.n2, selected.size(), region.nodes.size(), ms);
+    for (auto it = region.nodes.begin(); it != region.nodes.end(); ++it) {
+        fg.addNodeProp(*it, Flare::NodeProperty::Selected);
+    }
+
+    std::ostringstream ostringstr;
+    fg.storeGraphViz(ostringstr);
+    FILE *outf = _tfopen(ofilename, _T("w"));
+    std::string outs = ostringstr.str();
+    fwrite(outs.c_str(), 1, outs.size(), outf);
+    fclose(outf);
+    printf("Done\n");
+}
+
+
+// visible node count SP plans for, same as the plugin's default
+static const int g_simplifyTargetNodeCount = 30;
+
+// plans a simplification down to g_simplifyTargetNodeCount nodes and writes the
+// collapsed graph. each group becomes one node named after its entry, marked as
+// selected, with the group labels as comments at the top
+void handleSP(TCHAR* ifilename, TCHAR* ofilename) {
+    std::ifstream ifile(ifilename);
+
+    if (!ifile) {
+        _tprintf(_T("failed to open input file '%s'\n"), ifilename);
+        return;
+    }
+    Flare::FlareGraph fg;
+    bool ret = fg.loadGraphViz(ifile);
+    ifile.close();
+    if (!ret) {
+        printf("Failed to load dot file\n");
+        return;
+    }
+    Flare::collapsePlan_t plan;
+    auto start = std::chrono::steady_clock::now();
+    ret = fg.planSimplification(plan, g_simplifyTargetNodeCount, 3, 95);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!ret) {
+        printf("Failed to plan simplification\n");
+        return;
+    }
+    int visible = (plan.size() == 0) ? fg.getNodeCount() : plan.back().visibleNodes;
+    printf("Planned %d groups in %.3f ms: %d of %d nodes left visible\n", plan.size(), ms, visible, fg.getNodeCount());
+
+    // contract the groups in plan order, each one named after its entry
+    Flare::intvector_t groupNames(plan.size());
+    for (size_t g = 0; g < plan.size(); ++g) {
+        Flare::intvector_t members(1, plan[g].n1);
+        for (auto it = plan[g].nodes.begin(); it != plan[g].nodes.end(); ++it) {
+            if (*it != plan[g].n1) {
+                members.push_back(*it);
+            }
+        }
+        for (auto it = plan[g].groups.begin(); it != plan[g].groups.end(); ++it) {
+            members.push_back(groupNames[*it]);
+        }
+        groupNames[g] = fg.contractGroup(members);
+    }
+    Flare::intvector_t names;
+    fg.visibleNodes(names);
+    Flare::FlareGraph collapsed;
+    for (auto it = names.begin(); it != names.end(); ++it) {
+        collapsed.addNode(*it);
+    }
+    Flare::intvector_t succs;
+    for (auto it = names.begin(); it != names.end(); ++it) {
+        fg.visibleSuccs(*it, succs);
+        for (auto sit = succs.begin(); sit != succs.end(); ++sit) {
+            collapsed.addEdge(*it, *sit);
+        }
+    }
+
+    std::ostringstream ostringstr;
+    for (size_t g = 0; g < plan.size(); ++g) {
+        if (fg.groupOf(plan[g].n1) == plan[g].n1) {
+            collapsed.addNodeProp(plan[g].n1, Flare::NodeProperty::Selected);
+            ostringstr << "// group " << plan[g].n1 << ": " << plan[g].label << "\n";
+        }
+    }
+    collapsed.storeGraphViz(ostringstr);
+    FILE *outf = _tfopen(ofilename, _T("w"));
+    std::string outs = ostringstr.str();
+    fwrite(outs.c_str(), 1, outs.size(), outf);
+    fclose(outf);
+    printf("Done\n");
+}
+
 
 int _tmain(int argc, _TCHAR* argv[]) {
     printf("Hello World\n");
@@ -393,12 +627,24 @@ int _tmain(int argc, _TCHAR* argv[]) {
     bool doUR = false;
     bool doPD = false;
     bool doCT = false;
+    bool doPC = false;
+    bool doSW = false;
+    bool doEN = false;
+    bool doSP = false;
     if (_tcscmp(argv[1], _T("UR")) == 0) {
         doUR = true;
     } else if (_tcscmp(argv[1], _T("PD")) == 0) {
         doPD = true;
     } else if (_tcscmp(argv[1], _T("CT")) == 0) {
         doCT = true;
+    } else if (_tcscmp(argv[1], _T("PC")) == 0) {
+        doPC = true;
+    } else if (_tcscmp(argv[1], _T("SW")) == 0) {
+        doSW = true;
+    } else if (_tcscmp(argv[1], _T("EN")) == 0) {
+        doEN = true;
+    } else if (_tcscmp(argv[1], _T("SP")) == 0) {
+        doSP = true;
     } else {
         printf("Incorrect <cmd>: '%s'\n", argv[1]);
         printUsage(argv[0]);
@@ -410,6 +656,14 @@ int _tmain(int argc, _TCHAR* argv[]) {
         handlePD(argv[2], argv[3]);
     } else if (doCT) {
         handleCT(argv[2], argv[3]);
+    } else if (doPC) {
+        handlePC(argv[2], argv[3]);
+    } else if (doSW) {
+        handleSW(argv[2], argv[3]);
+    } else if (doEN) {
+        handleEN(argv[2], argv[3]);
+    } else if (doSP) {
+        handleSP(argv[2], argv[3]);
     }
 
     return 0;
@@ -34,6 +34,8 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <memory>
+#include <type_traits>
 
 
 #include <stdio.h>
@@ -1,661 +1,2746 @@
-// test.cpp : Defines the entry point for the console application.
-//
-
-#include "stdafx.h"
-
-#include "FlareGraph.hpp"
-#include <string>
-#include <sstream>
-
-#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
-#include "catch.hpp"
-
-std::string test1str = 
-"digraph G {\n"
-"    0 -> 1\n"
-"    0 -> 2\n"
-"    1 -> 3\n"
-"    2 -> 3\n"
-"    0 [ style=\"filled\" fillcolor=\"green\"]\n"
-"    1 [ style=\"filled\" fillcolor=\"lightskyblue\"]\n"
-"    2 [ style=\"filled\" fillcolor=\"gray\"]\n"
-"    3 [ style=\"filled\" fillcolor=\"firebrick1\"]\n"
-"}";
-
-std::string g_test2 = R"(// 00209820
-digraph G {
-    0 -> 1
-    0 -> 2
-    2 -> 3
-    2 -> 7
-    3 -> 4
-    3 -> 7
-    4 -> 5
-    4 -> 8
-    5 -> 6
-    6 -> 7
-    8 -> 6
-    8 -> 9
-    4 [ style="filled" fillcolor="green"]
-})";
-
-std::string g_test2_expect = R"(digraph G {
-    0 -> 1
-    0 -> 2
-    2 -> 3
-    2 -> 7
-    3 -> 4
-    3 -> 7
-    4 -> 5
-    4 -> 8
-    5 -> 6
-    6 -> 7
-    8 -> 6
-    8 -> 9
-    4 [ style="filled" fillcolor="green"]
-})";
-
-unsigned int Factorial(unsigned int number) {
-    return number <= 1 ? number : Factorial(number - 1)*number;
-}
-
-TEST_CASE("Factorials are computed", "[factorial]") {
-    REQUIRE(Factorial(1) == 1);
-    REQUIRE(Factorial(2) == 2);
-    REQUIRE(Factorial(3) == 6);
-    REQUIRE(Factorial(10) == 3628800);
-}
-
-TEST_CASE("Basic graph creation") {
-    Flare::FlareGraph fg;
-
-    REQUIRE(fg.getNodeCount() == 0);
-    fg.addNode(0);
-    fg.addNode(1);
-    fg.addNode(2);
-    fg.addNode(3);
-    REQUIRE(fg.getNodeCount() == 4);
-    fg.addEdge(0, 1);
-    fg.addEdge(0, 2);
-    fg.addEdge(1, 3);
-    fg.addEdge(2, 3);
-    fg.addNodeProp(0, Flare::NodeProperty::Root);
-    fg.addNodeProp(1, Flare::NodeProperty::Selected);
-    fg.addNodeProp(2, Flare::NodeProperty::Pruned);
-    fg.addNodeProp(3, Flare::NodeProperty::Sentry);
-    REQUIRE(fg.hasSucc(0, 1));
-    REQUIRE(fg.hasPred(0, 1));
-    REQUIRE(fg.hasSucc(0, 2));
-    REQUIRE(fg.hasPred(0, 2));
-    REQUIRE(fg.hasSucc(1, 3));
-    REQUIRE(fg.hasPred(1, 3));
-    REQUIRE(fg.hasSucc(2, 3));
-    REQUIRE(fg.hasPred(2, 3));
-    std::ostringstream ostringstr;
-    fg.storeGraphViz(ostringstr);
-    
-#if 0
-    FILE *outf = fopen("t1.gv", "w");
-    std::string outs = ostringstr.str();
-    fwrite(outs.c_str(), 1, outs.size(), outf);
-    fclose(outf);
-#endif
-
-    REQUIRE(ostringstr.str() == test1str);
-}
-
-TEST_CASE("Reacbale Test") {
-    Flare::FlareGraph fg;
-
-    fg.addNode(0);
-    fg.addNode(1);
-    fg.addNode(2);
-    fg.addNode(3);
-    fg.addNode(4);
-    fg.addNode(5);
-    fg.addNode(6);
-    fg.addEdge(0, 1);
-    fg.addEdge(0, 2);
-    fg.addEdge(1, 6);
-    fg.addEdge(2, 3);
-    fg.addEdge(2, 4);
-    fg.addEdge(3, 5);
-    fg.addEdge(4, 5);
-    fg.addEdge(5, 6);
-    fg.addNodeProp(2, Flare::NodeProperty::Root);
-
-    Flare::intset_t out1;
-    bool ret = fg.reachable(out1);
-    //fprintf(stderr, "Got %d reachable\n", out1.size());
-    Flare::intset_t expect1 = { 2, 3, 4, 5, 6 };
-    REQUIRE(out1 == expect1);
-
-    Flare::intset_t out2;
-    ret = fg.uniqueReachable(out2);
-    //fprintf(stderr, "Got %d reachable\n", out2.size());
-    Flare::intset_t expect2 = { 2, 3, 4, 5};
-    REQUIRE(out2 == expect2);
-
-
-    fg.clearNodeProp(2, Flare::NodeProperty::Root);
-    fg.addNodeProp(0, Flare::NodeProperty::Root);
-    Flare::intset_t out3;
-    ret = fg.reachable(out3);
-    //fprintf(stderr, "Got %d reachable\n", out3.size());
-    Flare::intset_t expect3 = { 0, 1, 2, 3, 4, 5, 6 };
-    REQUIRE(out3 == expect3);
-
-}
-
-TEST_CASE("GraphViz load") {
-    Flare::FlareGraph fg;
-    std::istringstream istream(g_test2);
-    fg.loadGraphViz(istream);
-    std::ostringstream ostringstr;
-    fg.storeGraphViz(ostringstr);
-    //printf("Got output: '%s'\n", ostringstr.str().c_str());
-    REQUIRE(ostringstr.str().c_str() == g_test2_expect);
-
-}
-
-TEST_CASE("DominatorCorrectness") {
-    // from boost test
-    // Tarjan's paper
-    Flare::FlareGraph fg;
-    //printf("Starting dominator test\n");
-    for (int i = 0; i < 13; ++i) {
-        fg.addNode(i);
-    }
-    // Tarjan's paper
-    fg.addEdge(0, 1);
-    fg.addEdge(0, 2);
-    fg.addEdge(0, 3);
-    fg.addEdge(1, 4);
-    fg.addEdge(2, 1);
-    fg.addEdge(2, 4);
-    fg.addEdge(2, 5);
-    fg.addEdge(3, 6);
-    fg.addEdge(3, 7);
-    fg.addEdge(4, 12);
-    fg.addEdge(5, 8);
-    fg.addEdge(6, 9);
-    fg.addEdge(7, 9);
-    fg.addEdge(7, 10);
-    fg.addEdge(8, 5);
-    fg.addEdge(8, 11);
-    fg.addEdge(9, 11);
-    fg.addEdge(10, 9);
-    fg.addEdge(11, 0);
-    fg.addEdge(11, 9);
-    fg.addEdge(12, 8);
-    Flare::intintMap_t correctIdoms;
-    correctIdoms[0] = -1;
-    correctIdoms[1] = 0; //1 
-    correctIdoms[2] = 0; //2
-    correctIdoms[3] = 0; //3
-    correctIdoms[4] = 0; //4
-    correctIdoms[5] = 0; //5
-    correctIdoms[6] = 3; //6
-    correctIdoms[7] = 3; //7
-    correctIdoms[8] = 0; //8
-    correctIdoms[9] = 0; //9
-    correctIdoms[10] = 7; //10
-    correctIdoms[11] = 0; //11
-    correctIdoms[12] = 4; //12
-    Flare::intintMap_t res;
-    bool ret = fg.idom(res, 0);
-    REQUIRE(ret == true);
-    //for (auto it = correctIdoms.begin(); it != correctIdoms.end(); ++it) {
-    //    printf("correctIdoms[%d] = %d\n", it->first, it->second);
-    //}
-    //printf("res size: %d\n", res.size());
-    //for (auto it = res.begin(); it != res.end(); ++it) {
-    //    printf("res[%d] = %d\n", it->first, it->second);
-    //}
-    REQUIRE(res == correctIdoms);
-
-
-}
-
-
-
-struct DominatorCorrectnessTestSet
-{
-  typedef std::pair<int, int> edge;
-
-  int numOfVertices;
-  int start;
-  std::vector<edge> edges;
-  std::vector<int> correctIdoms;
-};
-
-
-TEST_CASE("DominatorCorrectness2") {
-  typedef DominatorCorrectnessTestSet::edge edge;
-
-  DominatorCorrectnessTestSet testSet[7];
-
-  // Tarjan's paper
-  testSet[0].numOfVertices = 13;
-  testSet[0].start = 0,
-  testSet[0].edges.push_back(edge(0, 1));
-  testSet[0].edges.push_back(edge(0, 2));
-  testSet[0].edges.push_back(edge(0, 3));
-  testSet[0].edges.push_back(edge(1, 4));
-  testSet[0].edges.push_back(edge(2, 1));
-  testSet[0].edges.push_back(edge(2, 4));
-  testSet[0].edges.push_back(edge(2, 5));
-  testSet[0].edges.push_back(edge(3, 6));
-  testSet[0].edges.push_back(edge(3, 7));
-  testSet[0].edges.push_back(edge(4, 12));
-  testSet[0].edges.push_back(edge(5, 8));
-  testSet[0].edges.push_back(edge(6, 9));
-  testSet[0].edges.push_back(edge(7, 9));
-  testSet[0].edges.push_back(edge(7, 10));
-  testSet[0].edges.push_back(edge(8, 5));
-  testSet[0].edges.push_back(edge(8, 11));
-  testSet[0].edges.push_back(edge(9, 11));
-  testSet[0].edges.push_back(edge(10, 9));
-  testSet[0].edges.push_back(edge(11, 0));
-  testSet[0].edges.push_back(edge(11, 9));
-  testSet[0].edges.push_back(edge(12, 8));
-  testSet[0].correctIdoms.push_back(-1);
-  testSet[0].correctIdoms.push_back(0);
-  testSet[0].correctIdoms.push_back(0);
-  testSet[0].correctIdoms.push_back(0);
-  testSet[0].correctIdoms.push_back(0);
-  testSet[0].correctIdoms.push_back(0);
-  testSet[0].correctIdoms.push_back(3);
-  testSet[0].correctIdoms.push_back(3);
-  testSet[0].correctIdoms.push_back(0);
-  testSet[0].correctIdoms.push_back(0);
-  testSet[0].correctIdoms.push_back(7);
-  testSet[0].correctIdoms.push_back(0);
-  testSet[0].correctIdoms.push_back(4);
-
-  // Appel. p441. figure 19.4
-  testSet[1].numOfVertices = 7;
-  testSet[1].start = 0,
-  testSet[1].edges.push_back(edge(0, 1));
-  testSet[1].edges.push_back(edge(1, 2));
-  testSet[1].edges.push_back(edge(1, 3));
-  testSet[1].edges.push_back(edge(2, 4));
-  testSet[1].edges.push_back(edge(2, 5));
-  testSet[1].edges.push_back(edge(4, 6));
-  testSet[1].edges.push_back(edge(5, 6));
-  testSet[1].edges.push_back(edge(6, 1));
-  testSet[1].correctIdoms.push_back(-1);
-  testSet[1].correctIdoms.push_back(0);
-  testSet[1].correctIdoms.push_back(1);
-  testSet[1].correctIdoms.push_back(1);
-  testSet[1].correctIdoms.push_back(2);
-  testSet[1].correctIdoms.push_back(2);
-  testSet[1].correctIdoms.push_back(2);
-
-  // Appel. p449. figure 19.8
-  testSet[2].numOfVertices = 13,
-  testSet[2].start = 0,
-  testSet[2].edges.push_back(edge(0, 1));
-  testSet[2].edges.push_back(edge(0, 2));
-  testSet[2].edges.push_back(edge(1, 3));
-  testSet[2].edges.push_back(edge(1, 6));
-  testSet[2].edges.push_back(edge(2, 4));
-  testSet[2].edges.push_back(edge(2, 7));
-  testSet[2].edges.push_back(edge(3, 5));
-  testSet[2].edges.push_back(edge(3, 6));
-  testSet[2].edges.push_back(edge(4, 7));
-  testSet[2].edges.push_back(edge(4, 2));
-  testSet[2].edges.push_back(edge(5, 8));
-  testSet[2].edges.push_back(edge(5, 10));
-  testSet[2].edges.push_back(edge(6, 9));
-  testSet[2].edges.push_back(edge(7, 12));
-  testSet[2].edges.push_back(edge(8, 11));
-  testSet[2].edges.push_back(edge(9, 8));
-  testSet[2].edges.push_back(edge(10, 11));
-  testSet[2].edges.push_back(edge(11, 1));
-  testSet[2].edges.push_back(edge(11, 12));
-  testSet[2].correctIdoms.push_back(-1);
-  testSet[2].correctIdoms.push_back(0);
-  testSet[2].correctIdoms.push_back(0);
-  testSet[2].correctIdoms.push_back(1);
-  testSet[2].correctIdoms.push_back(2);
-  testSet[2].correctIdoms.push_back(3);
-  testSet[2].correctIdoms.push_back(1);
-  testSet[2].correctIdoms.push_back(2);
-  testSet[2].correctIdoms.push_back(1);
-  testSet[2].correctIdoms.push_back(6);
-  testSet[2].correctIdoms.push_back(5);
-  testSet[2].correctIdoms.push_back(1);
-  testSet[2].correctIdoms.push_back(0);
-
-  testSet[3].numOfVertices = 8,
-  testSet[3].start = 0,
-  testSet[3].edges.push_back(edge(0, 1));
-  testSet[3].edges.push_back(edge(1, 2));
-  testSet[3].edges.push_back(edge(1, 3));
-  testSet[3].edges.push_back(edge(2, 7));
-  testSet[3].edges.push_back(edge(3, 4));
-  testSet[3].edges.push_back(edge(4, 5));
-  testSet[3].edges.push_back(edge(4, 6));
-  testSet[3].edges.push_back(edge(5, 7));
-  testSet[3].edges.push_back(edge(6, 4));
-  testSet[3].correctIdoms.push_back(-1);
-  testSet[3].correctIdoms.push_back(0);
-  testSet[3].correctIdoms.push_back(1);
-  testSet[3].correctIdoms.push_back(1);
-  testSet[3].correctIdoms.push_back(3);
-  testSet[3].correctIdoms.push_back(4);
-  testSet[3].correctIdoms.push_back(4);
-  testSet[3].correctIdoms.push_back(1);
-  
-  // Muchnick. p256. figure 8.21
-  testSet[4].numOfVertices = 8,
-  testSet[4].start = 0,
-  testSet[4].edges.push_back(edge(0, 1));
-  testSet[4].edges.push_back(edge(1, 2));
-  testSet[4].edges.push_back(edge(2, 3));
-  testSet[4].edges.push_back(edge(2, 4));
-  testSet[4].edges.push_back(edge(3, 2));
-  testSet[4].edges.push_back(edge(4, 5));
-  testSet[4].edges.push_back(edge(4, 6));
-  testSet[4].edges.push_back(edge(5, 7));
-  testSet[4].edges.push_back(edge(6, 7));
-  testSet[4].correctIdoms.push_back(-1);
-  testSet[4].correctIdoms.push_back(0);
-  testSet[4].correctIdoms.push_back(1);
-  testSet[4].correctIdoms.push_back(2);
-  testSet[4].correctIdoms.push_back(2);
-  testSet[4].correctIdoms.push_back(4);
-  testSet[4].correctIdoms.push_back(4);
-  testSet[4].correctIdoms.push_back(4);
-
-  // Muchnick. p253. figure 8.18
-  testSet[5].numOfVertices = 8,
-  testSet[5].start = 0,
-  testSet[5].edges.push_back(edge(0, 1));
-  testSet[5].edges.push_back(edge(0, 2));
-  testSet[5].edges.push_back(edge(1, 6));
-  testSet[5].edges.push_back(edge(2, 3));
-  testSet[5].edges.push_back(edge(2, 4));
-  testSet[5].edges.push_back(edge(3, 7));
-  testSet[5].edges.push_back(edge(5, 7));
-  testSet[5].edges.push_back(edge(6, 7));
-  testSet[5].correctIdoms.push_back(-1);
-  testSet[5].correctIdoms.push_back(0);
-  testSet[5].correctIdoms.push_back(0);
-  testSet[5].correctIdoms.push_back(2);
-  testSet[5].correctIdoms.push_back(2);
-  testSet[5].correctIdoms.push_back(-1);
-  testSet[5].correctIdoms.push_back(1);
-  testSet[5].correctIdoms.push_back(0);
-
-  // Cytron's paper, fig. 9
-  testSet[6].numOfVertices = 14,
-  testSet[6].start = 0,
-  testSet[6].edges.push_back(edge(0, 1));
-  testSet[6].edges.push_back(edge(0, 13));
-  testSet[6].edges.push_back(edge(1, 2));
-  testSet[6].edges.push_back(edge(2, 3));
-  testSet[6].edges.push_back(edge(2, 7));
-  testSet[6].edges.push_back(edge(3, 4));
-  testSet[6].edges.push_back(edge(3, 5));
-  testSet[6].edges.push_back(edge(4, 6));
-  testSet[6].edges.push_back(edge(5, 6));
-  testSet[6].edges.push_back(edge(6, 8));
-  testSet[6].edges.push_back(edge(7, 8));
-  testSet[6].edges.push_back(edge(8, 9));
-  testSet[6].edges.push_back(edge(9, 10));
-  testSet[6].edges.push_back(edge(9, 11));
-  testSet[6].edges.push_back(edge(10, 11));
-  testSet[6].edges.push_back(edge(11, 9));
-  testSet[6].edges.push_back(edge(11, 12));
-  testSet[6].edges.push_back(edge(12, 2));
-  testSet[6].edges.push_back(edge(12, 13));
-  testSet[6].correctIdoms.push_back(-1);
-  testSet[6].correctIdoms.push_back(0);
-  testSet[6].correctIdoms.push_back(1);
-  testSet[6].correctIdoms.push_back(2);
-  testSet[6].correctIdoms.push_back(3);
-  testSet[6].correctIdoms.push_back(3);
-  testSet[6].correctIdoms.push_back(3);
-  testSet[6].correctIdoms.push_back(2);
-  testSet[6].correctIdoms.push_back(2);
-  testSet[6].correctIdoms.push_back(8);
-  testSet[6].correctIdoms.push_back(9);
-  testSet[6].correctIdoms.push_back(9);
-  testSet[6].correctIdoms.push_back(11);
-  testSet[6].correctIdoms.push_back(0);
-
-  for (size_t i = 0; i < sizeof(testSet)/sizeof(testSet[0]); ++i) {
-    const int numOfVertices = testSet[i].numOfVertices;
-    Flare::FlareGraph fg;
-    //printf("Starting dominator test\n");
-    for (int j = 0; j < numOfVertices; ++j) {
-        fg.addNode(j);
-    }
-    for (unsigned int j = 0; j < testSet[i].edges.size(); ++j) {
-        fg.addEdge(testSet[i].edges[j].first, testSet[i].edges[j].second);
-    }
-
-    Flare::intintMap_t res;
-    bool ret = fg.idom(res, testSet[i].start);
-    REQUIRE(ret == true);
-    REQUIRE(res.size() == testSet[i].correctIdoms.size());
-    for (unsigned int j = 0; j < testSet[i].correctIdoms.size(); ++j) {
-        REQUIRE(testSet[i].correctIdoms[j] == res[j]);
-    }
-#if 0
-    for (auto it = correctIdoms.begin(); it != correctIdoms.end(); ++it) {
-        printf("correctIdoms[%d] = %d\n", it->first, it->second);
-    }
-    printf("res size: %d\n", res.size());
-    for (auto it = res.begin(); it != res.end(); ++it) {
-        printf("res[%d] = %d\n", it->first, it->second);
-    }
-#endif
-  }
-}
-
-
-TEST_CASE("PostDominator test") {
-    typedef DominatorCorrectnessTestSet::edge edge;
-
-    // http://web.cse.ohio-state.edu/~rountev.1/788/lectures/ControlFlowAnalysis.pdf
-    // slide 13/14
-    DominatorCorrectnessTestSet testSet[3];
-    testSet[0].numOfVertices = 12;
-    testSet[0].start = 11;
-    testSet[0].edges.push_back(edge(0,1));
-    testSet[0].edges.push_back(edge(1,2));
-    testSet[0].edges.push_back(edge(1,3));
-    testSet[0].edges.push_back(edge(2,3));
-    testSet[0].edges.push_back(edge(3,4));
-    testSet[0].edges.push_back(edge(4,3));
-    testSet[0].edges.push_back(edge(4,6));
-    testSet[0].edges.push_back(edge(4,5));
-    testSet[0].edges.push_back(edge(5,7));
-    testSet[0].edges.push_back(edge(6,7));
-    testSet[0].edges.push_back(edge(7,4));
-    testSet[0].edges.push_back(edge(7,8));
-    testSet[0].edges.push_back(edge(8,3));
-    testSet[0].edges.push_back(edge(8,9));
-    testSet[0].edges.push_back(edge(8,10));
-    testSet[0].edges.push_back(edge(9,1));
-    testSet[0].edges.push_back(edge(10,7));
-    testSet[0].edges.push_back(edge(10,11));
-    testSet[0].correctIdoms.push_back(1);
-    testSet[0].correctIdoms.push_back(3);
-    testSet[0].correctIdoms.push_back(3);
-    testSet[0].correctIdoms.push_back(4);
-    testSet[0].correctIdoms.push_back(7);
-    testSet[0].correctIdoms.push_back(7);
-    testSet[0].correctIdoms.push_back(7);
-    testSet[0].correctIdoms.push_back(8);
-    testSet[0].correctIdoms.push_back(10);
-    testSet[0].correctIdoms.push_back(1);
-    testSet[0].correctIdoms.push_back(11);
-    testSet[0].correctIdoms.push_back(-1);
-
-
-    // http://pages.cs.wisc.edu/~fischer/cs701.f08/lectures/Lecture19.4up.pdf
-    // slide 406
-    testSet[1].numOfVertices = 6;
-    testSet[1].start = 5;
-    testSet[1].edges.push_back(edge(0,1));
-    testSet[1].edges.push_back(edge(0,5));
-    testSet[1].edges.push_back(edge(1,2));
-    testSet[1].edges.push_back(edge(1,3));
-    testSet[1].edges.push_back(edge(2,4));
-    testSet[1].edges.push_back(edge(3,4));
-    testSet[1].edges.push_back(edge(4,5));
-    testSet[1].correctIdoms.push_back(5);
-    testSet[1].correctIdoms.push_back(4);
-    testSet[1].correctIdoms.push_back(4);
-    testSet[1].correctIdoms.push_back(4);
-    testSet[1].correctIdoms.push_back(5);
-    testSet[1].correctIdoms.push_back(-1);
-
-    // http://www.cs.kent.edu/~jmaletic/cs63901/lectures/StaticAnalysis.pdf
-    testSet[2].numOfVertices = 7;
-    testSet[2].start = 6;
-    testSet[2].edges.push_back(edge(0,1));
-    testSet[2].edges.push_back(edge(0,2));
-    testSet[2].edges.push_back(edge(1,3));
-    testSet[2].edges.push_back(edge(1,4));
-    testSet[2].edges.push_back(edge(2,4));
-    testSet[2].edges.push_back(edge(2,6));
-    testSet[2].edges.push_back(edge(3,5));
-    testSet[2].edges.push_back(edge(4,5));
-    testSet[2].edges.push_back(edge(5,6));
-    testSet[2].correctIdoms.push_back(6);
-    testSet[2].correctIdoms.push_back(5);
-    testSet[2].correctIdoms.push_back(6);
-    testSet[2].correctIdoms.push_back(5);
-    testSet[2].correctIdoms.push_back(5);
-    testSet[2].correctIdoms.push_back(6);
-    testSet[2].correctIdoms.push_back(-1);
-
-
-    //printf("Starting postdominator test\n");
-
-    for (size_t i = 0; i < sizeof(testSet)/sizeof(testSet[0]); ++i) {
-        //for (unsigned int j = 0; j < testSet[i].correctIdoms.size(); ++j) {
-        //    printf("correctIdoms[%d] = %d\n", j, testSet[i].correctIdoms[j]);
-        //}
-        int correctCount = 0;
-        
-        Flare::FlareGraph fg;
-
-        for (int j = 0; j < testSet[i].numOfVertices; ++j) {
-            fg.addNode(j);
-        }
-        for (unsigned int j = 0; j < testSet[i].edges.size(); ++j) {
-            fg.addEdge(testSet[i].edges[j].first, testSet[i].edges[j].second);
-        }
-        std::ostringstream ostringstr;
-        fg.storeGraphViz(ostringstr);
-        //printf("%d postdom testgraph:\n%s\n", i, ostringstr.str());
-        Flare::intintMap_t res;
-        //printf("Starting ipdom\n");
-        bool ret = fg.ipdom(res, testSet[i].start);
-        REQUIRE(ret == true);
-        REQUIRE(res.size() == testSet[i].correctIdoms.size());
-        //for (auto it = res.begin(); it != res.end(); ++it) {
-        //    printf("res[%d] = %d\n", it->first, it->second);
-        //}
-        for (unsigned int j = 0; j < testSet[i].correctIdoms.size(); ++j) {
-            //REQUIRE(testSet[i].correctIdoms[j] == res[j]);
-            if (testSet[i].correctIdoms[j] == res[j]) {
-                ++correctCount;
-            } else {
-                printf("Incorrect res[%d]: %d vs %d\n", j, testSet[i].correctIdoms[j], res[j]);
-            }
-        }
-        REQUIRE(correctCount == testSet[i].correctIdoms.size());
-    }
-}
-
-
-
-TEST_CASE("PostDominatorGroupTest") {
-
-std::string test1str = R"(
-// file Z:\customer\2017\53142\smartidb_e3c5bd27d02977859acc6ce5570769a8.idb
-// function 20a4c0
-digraph G {
-    0 -> 1
-    0 -> 15
-    1 -> 15
-    1 -> 2
-    10 -> 11
-    10 -> 16
-    11 -> 12
-    12 -> 12
-    12 -> 13
-    13 -> 14
-    13 -> 16
-    14 -> 15
-    2 -> 11
-    2 -> 3
-    3 -> 4
-    4 -> 5
-    4 -> 9
-    5 -> 6
-    5 -> 8
-    6 -> 7
-    6 -> 9
-    7 -> 4
-    7 -> 8
-    8 -> 10
-    9 -> 10
-    4 [ style="filled" fillcolor="green"]
-})";
-
-std::string test1strsolution = R"(digraph G {
-    0 -> 1
-    0 -> 15
-    1 -> 15
-    1 -> 2
-    10 -> 11
-    10 -> 16
-    11 -> 12
-    12 -> 12
-    12 -> 13
-    13 -> 14
-    13 -> 16
-    14 -> 15
-    2 -> 11
-    2 -> 3
-    3 -> 4
-    4 -> 5
-    4 -> 9
-    5 -> 6
-    5 -> 8
-    6 -> 7
-    6 -> 9
-    7 -> 4
-    7 -> 8
-    8 -> 10
-    9 -> 10
-    10 [ style="filled" fillcolor="lightskyblue"]
-    4 [ style="filled" fillcolor="green"]
-    5 [ style="filled" fillcolor="lightskyblue"]
-    6 [ style="filled" fillcolor="lightskyblue"]
-    7 [ style="filled" fillcolor="lightskyblue"]
-    8 [ style="filled" fillcolor="lightskyblue"]
-    9 [ style="filled" fillcolor="lightskyblue"]
-})";
-
-    Flare::FlareGraph fg;
-    std::istringstream istream(test1str);
-    fg.loadGraphViz(istream);
-    Flare::intset_t pdomgroup;
-    bool ret = fg.getpdomGroup(pdomgroup, fg.getRootNode());
-    REQUIRE(ret == true);
-    fg.selectNodes(pdomgroup);
-    std::ostringstream ostringstr;
-    fg.storeGraphViz(ostringstr);
-    //printf("Got output: '%s'\n", ostringstr.str().c_str());
-    REQUIRE(ostringstr.str().c_str() == test1strsolution);
-
-}
+// test.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+
+#include "FlareGraph.hpp"
+#include "FlareGraphBoost.hpp"
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <boost/graph/strong_components.hpp>
+#include <boost/graph/topological_sort.hpp>
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+std::string test1str = 
+"digraph G {\n"
+"    0 -> 1\n"
+"    0 -> 2\n"
+"    1 -> 3\n"
+"    2 -> 3\n"
+"    0 [ style=\"filled\" fillcolor=\"green\"]\n"
+"    1 [ style=\"filled\" fillcolor=\"lightskyblue\"]\n"
+"    2 [ style=\"filled\" fillcolor=\"gray\"]\n"
+"    3 [ style=\"filled\" fillcolor=\"firebrick1\"]\n"
+"}";
+
+std::string g_test2 = R"(// 00209820
+digraph G {
+    0 -> 1
+    0 -> 2
+    2 -> 3
+    2 -> 7
+    3 -> 4
+    3 -> 7
+    4 -> 5
+    4 -> 8
+    5 -> 6
+    6 -> 7
+    8 -> 6
+    8 -> 9
+    4 [ style="filled" fillcolor="green"]
+})";
+
+std::string g_test2_expect = R"(digraph G {
+    0 -> 1
+    0 -> 2
+    2 -> 3
+    2 -> 7
+    3 -> 4
+    3 -> 7
+    4 -> 5
+    4 -> 8
+    5 -> 6
+    6 -> 7
+    8 -> 6
+    8 -> 9
+    4 [ style="filled" fillcolor="green"]
+})";
+
+unsigned int Factorial(unsigned int number) {
+    return number <= 1 ? number : Factorial(number - 1)*number;
+}
+
+TEST_CASE("Factorials are computed", "[factorial]") {
+    REQUIRE(Factorial(1) == 1);
+    REQUIRE(Factorial(2) == 2);
+    REQUIRE(Factorial(3) == 6);
+    REQUIRE(Factorial(10) == 3628800);
+}
+
+TEST_CASE("Basic graph creation") {
+    Flare::FlareGraph fg;
+
+    REQUIRE(fg.getNodeCount() == 0);
+    fg.addNode(0);
+    fg.addNode(1);
+    fg.addNode(2);
+    fg.addNode(3);
+    REQUIRE(fg.getNodeCount() == 4);
+    fg.addEdge(0, 1);
+    fg.addEdge(0, 2);
+    fg.addEdge(1, 3);
+    fg.addEdge(2, 3);
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    fg.addNodeProp(1, Flare::NodeProperty::Selected);
+    fg.addNodeProp(2, Flare::NodeProperty::Pruned);
+    fg.addNodeProp(3, Flare::NodeProperty::Sentry);
+    REQUIRE(fg.hasSucc(0, 1));
+    REQUIRE(fg.hasPred(0, 1));
+    REQUIRE(fg.hasSucc(0, 2));
+    REQUIRE(fg.hasPred(0, 2));
+    REQUIRE(fg.hasSucc(1, 3));
+    REQUIRE(fg.hasPred(1, 3));
+    REQUIRE(fg.hasSucc(2, 3));
+    REQUIRE(fg.hasPred(2, 3));
+    std::ostringstream ostringstr;
+    fg.storeGraphViz(ostringstr);
+    
+#if 0
+    FILE *outf = fopen("t1.gv", "w");
+    std::string outs = ostringstr.str();
+    fwrite(outs.c_str(), 1, outs.size(), outf);
+    fclose(outf);
+#endif
+
+    REQUIRE(ostringstr.str() == test1str);
+}
+
+TEST_CASE("Reacbale Test") {
+    Flare::FlareGraph fg;
+
+    fg.addNode(0);
+    fg.addNode(1);
+    fg.addNode(2);
+    fg.addNode(3);
+    fg.addNode(4);
+    fg.addNode(5);
+    fg.addNode(6);
+    fg.addEdge(0, 1);
+    fg.addEdge(0, 2);
+    fg.addEdge(1, 6);
+    fg.addEdge(2, 3);
+    fg.addEdge(2, 4);
+    fg.addEdge(3, 5);
+    fg.addEdge(4, 5);
+    fg.addEdge(5, 6);
+    fg.addNodeProp(2, Flare::NodeProperty::Root);
+
+    Flare::intset_t out1;
+    bool ret = fg.reachable(out1);
+    //fprintf(stderr, "Got %d reachable\n", out1.size());
+    Flare::intset_t expect1 = { 2, 3, 4, 5, 6 };
+    REQUIRE(out1 == expect1);
+
+    Flare::intset_t out2;
+    ret = fg.uniqueReachable(out2);
+    //fprintf(stderr, "Got %d reachable\n", out2.size());
+    Flare::intset_t expect2 = { 2, 3, 4, 5};
+    REQUIRE(out2 == expect2);
+
+
+    fg.clearNodeProp(2, Flare::NodeProperty::Root);
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    Flare::intset_t out3;
+    ret = fg.reachable(out3);
+    //fprintf(stderr, "Got %d reachable\n", out3.size());
+    Flare::intset_t expect3 = { 0, 1, 2, 3, 4, 5, 6 };
+    REQUIRE(out3 == expect3);
+
+}
+
+TEST_CASE("GraphViz load") {
+    Flare::FlareGraph fg;
+    std::istringstream istream(g_test2);
+    fg.loadGraphViz(istream);
+    std::ostringstream ostringstr;
+    fg.storeGraphViz(ostringstr);
+    //printf("Got output: '%s'\n", ostringstr.str().c_str());
+    REQUIRE(ostringstr.str().c_str() == g_test2_expect);
+
+}
+
+TEST_CASE("DominatorCorrectness") {
+    // from boost test
+    // Tarjan's paper
+    Flare::FlareGraph fg;
+    //printf("Starting dominator test\n");
+    for (int i = 0; i < 13; ++i) {
+        fg.addNode(i);
+    }
+    // Tarjan's paper
+    fg.addEdge(0, 1);
+    fg.addEdge(0, 2);
+    fg.addEdge(0, 3);
+    fg.addEdge(1, 4);
+    fg.addEdge(2, 1);
+    fg.addEdge(2, 4);
+    fg.addEdge(2, 5);
+    fg.addEdge(3, 6);
+    fg.addEdge(3, 7);
+    fg.addEdge(4, 12);
+    fg.addEdge(5, 8);
+    fg.addEdge(6, 9);
+    fg.addEdge(7, 9);
+    fg.addEdge(7, 10);
+    fg.addEdge(8, 5);
+    fg.addEdge(8, 11);
+    fg.addEdge(9, 11);
+    fg.addEdge(10, 9);
+    fg.addEdge(11, 0);
+    fg.addEdge(11, 9);
+    fg.addEdge(12, 8);
+    Flare::intintMap_t correctIdoms;
+    correctIdoms[0] = -1;
+    correctIdoms[1] = 0; //1 
+    correctIdoms[2] = 0; //2
+    correctIdoms[3] = 0; //3
+    correctIdoms[4] = 0; //4
+    correctIdoms[5] = 0; //5
+    correctIdoms[6] = 3; //6
+    correctIdoms[7] = 3; //7
+    correctIdoms[8] = 0; //8
+    correctIdoms[9] = 0; //9
+    correctIdoms[10] = 7; //10
+    correctIdoms[11] = 0; //11
+    correctIdoms[12] = 4; //12
+    Flare::intintMap_t res;
+    bool ret = fg.idom(res, 0);
+    REQUIRE(ret == true);
+    //for (auto it = correctIdoms.begin(); it != correctIdoms.end(); ++it) {
+    //    printf("correctIdoms[%d] = %d\n", it->first, it->second);
+    //}
+    //printf("res size: %d\n", res.size());
+    //for (auto it = res.begin(); it != res.end(); ++it) {
+    //    printf("res[%d] = %d\n", it->first, it->second);
+    //}
+    REQUIRE(res == correctIdoms);
+
+
+}
+
+
+
+struct DominatorCorrectnessTestSet
+{
+  typedef std::pair<int, int> edge;
+
+  int numOfVertices;
+  int start;
+  std::vector<edge> edges;
+  std::vector<int> correctIdoms;
+};
+
+
+TEST_CASE("DominatorCorrectness2") {
+  typedef DominatorCorrectnessTestSet::edge edge;
+
+  DominatorCorrectnessTestSet testSet[7];
+
+  // Tarjan's paper
+  testSet[0].numOfVertices = 13;
+  testSet[0].start = 0,
+  testSet[0].edges.push_back(edge(0, 1));
+  testSet[0].edges.push_back(edge(0, 2));
+  testSet[0].edges.push_back(edge(0, 3));
+  testSet[0].edges.push_back(edge(1, 4));
+  testSet[0].edges.push_back(edge(2, 1));
+  testSet[0].edges.push_back(edge(2, 4));
+  testSet[0].edges.push_back(edge(2, 5));
+  testSet[0].edges.push_back(edge(3, 6));
+  testSet[0].edges.push_back(edge(3, 7));
+  testSet[0].edges.push_back(edge(4, 12));
+  testSet[0].edges.push_back(edge(5, 8));
+  testSet[0].edges.push_back(edge(6, 9));
+  testSet[0].edges.push_back(edge(7, 9));
+  testSet[0].edges.push_back(edge(7, 10));
+  testSet[0].edges.push_back(edge(8, 5));
+  testSet[0].edges.push_back(edge(8, 11));
+  testSet[0].edges.push_back(edge(9, 11));
+  testSet[0].edges.push_back(edge(10, 9));
+  testSet[0].edges.push_back(edge(11, 0));
+  testSet[0].edges.push_back(edge(11, 9));
+  testSet[0].edges.push_back(edge(12, 8));
+  testSet[0].correctIdoms.push_back(-1);
+  testSet[0].correctIdoms.push_back(0);
+  testSet[0].correctIdoms.push_back(0);
+  testSet[0].correctIdoms.push_back(0);
+  testSet[0].correctIdoms.push_back(0);
+  testSet[0].correctIdoms.push_back(0);
+  testSet[0].correctIdoms.push_back(3);
+  testSet[0].correctIdoms.push_back(3);
+  testSet[0].correctIdoms.push_back(0);
+  testSet[0].correctIdoms.push_back(0);
+  testSet[0].correctIdoms.push_back(7);
+  testSet[0].correctIdoms.push_back(0);
+  testSet[0].correctIdoms.push_back(4);
+
+  // Appel. p441. figure 19.4
+  testSet[1].numOfVertices = 7;
+  testSet[1].start = 0,
+  testSet[1].edges.push_back(edge(0, 1));
+  testSet[1].edges.push_back(edge(1, 2));
+  testSet[1].edges.push_back(edge(1, 3));
+  testSet[1].edges.push_back(edge(2, 4));
+  testSet[1].edges.push_back(edge(2, 5));
+  testSet[1].edges.push_back(edge(4, 6));
+  testSet[1].edges.push_back(edge(5, 6));
+  testSet[1].edges.push_back(edge(6, 1));
+  testSet[1].correctIdoms.push_back(-1);
+  testSet[1].correctIdoms.push_back(0);
+  testSet[1].correctIdoms.push_back(1);
+  testSet[1].correctIdoms.push_back(1);
+  testSet[1].correctIdoms.push_back(2);
+  testSet[1].correctIdoms.push_back(2);
+  testSet[1].correctIdoms.push_back(2);
+
+  // Appel. p449. figure 19.8
+  testSet[2].numOfVertices = 13,
+  testSet[2].start = 0,
+  testSet[2].edges.push_back(edge(0, 1));
+  testSet[2].edges.push_back(edge(0, 2));
+  testSet[2].edges.push_back(edge(1, 3));
+  testSet[2].edges.push_back(edge(1, 6));
+  testSet[2].edges.push_back(edge(2, 4));
+  testSet[2].edges.push_back(edge(2, 7));
+  testSet[2].edges.push_back(edge(3, 5));
+  testSet[2].edges.push_back(edge(3, 6));
+  testSet[2].edges.push_back(edge(4, 7));
+  testSet[2].edges.push_back(edge(4, 2));
+  testSet[2].edges.push_back(edge(5, 8));
+  testSet[2].edges.push_back(edge(5, 10));
+  testSet[2].edges.push_back(edge(6, 9));
+  testSet[2].edges.push_back(edge(7, 12));
+  testSet[2].edges.push_back(edge(8, 11));
+  testSet[2].edges.push_back(edge(9, 8));
+  testSet[2].edges.push_back(edge(10, 11));
+  testSet[2].edges.push_back(edge(11, 1));
+  testSet[2].edges.push_back(edge(11, 12));
+  testSet[2].correctIdoms.push_back(-1);
+  testSet[2].correctIdoms.push_back(0);
+  testSet[2].correctIdoms.push_back(0);
+  testSet[2].correctIdoms.push_back(1);
+  testSet[2].correctIdoms.push_back(2);
+  testSet[2].correctIdoms.push_back(3);
+  testSet[2].correctIdoms.push_back(1);
+  testSet[2].correctIdoms.push_back(2);
+  testSet[2].correctIdoms.push_back(1);
+  testSet[2].correctIdoms.push_back(6);
+  testSet[2].correctIdoms.push_back(5);
+  testSet[2].correctIdoms.push_back(1);
+  testSet[2].correctIdoms.push_back(0);
+
+  testSet[3].numOfVertices = 8,
+  testSet[3].start = 0,
+  testSet[3].edges.push_back(edge(0, 1));
+  testSet[3].edges.push_back(edge(1, 2));
+  testSet[3].edges.push_back(edge(1, 3));
+  testSet[3].edges.push_back(edge(2, 7));
+  testSet[3].edges.push_back(edge(3, 4));
+  testSet[3].edges.push_back(edge(4, 5));
+  testSet[3].edges.push_back(edge(4, 6));
+  testSet[3].edges.push_back(edge(5, 7));
+  testSet[3].edges.push_back(edge(6, 4));
+  testSet[3].correctIdoms.push_back(-1);
+  testSet[3].correctIdoms.push_back(0);
+  testSet[3].correctIdoms.push_back(1);
+  testSet[3].correctIdoms.push_back(1);
+  testSet[3].correctIdoms.push_back(3);
+  testSet[3].correctIdoms.push_back(4);
+  testSet[3].correctIdoms.push_back(4);
+  testSet[3].correctIdoms.push_back(1);
+  
+  // Muchnick. p256. figure 8.21
+  testSet[4].numOfVertices = 8,
+  testSet[4].start = 0,
+  testSet[4].edges.push_back(edge(0, 1));
+  testSet[4].edges.push_back(edge(1, 2));
+  testSet[4].edges.push_back(edge(2, 3));
+  testSet[4].edges.push_back(edge(2, 4));
+  testSet[4].edges.push_back(edge(3, 2));
+  testSet[4].edges.push_back(edge(4, 5));
+  testSet[4].edges.push_back(edge(4, 6));
+  testSet[4].edges.push_back(edge(5, 7));
+  testSet[4].edges.push_back(edge(6, 7));
+  testSet[4].correctIdoms.push_back(-1);
+  testSet[4].correctIdoms.push_back(0);
+  testSet[4].correctIdoms.push_back(1);
+  testSet[4].correctIdoms.push_back(2);
+  testSet[4].correctIdoms.push_back(2);
+  testSet[4].correctIdoms.push_back(4);
+  testSet[4].correctIdoms.push_back(4);
+  testSet[4].correctIdoms.push_back(4);
+
+  // Muchnick. p253. figure 8.18
+  testSet[5].numOfVertices = 8,
+  testSet[5].start = 0,
+  testSet[5].edges.push_back(edge(0, 1));
+  testSet[5].edges.push_back(edge(0, 2));
+  testSet[5].edges.push_back(edge(1, 6));
+  testSet[5].edges.push_back(edge(2, 3));
+  testSet[5].edges.push_back(edge(2, 4));
+  testSet[5].edges.push_back(edge(3, 7));
+  testSet[5].edges.push_back(edge(5, 7));
+  testSet[5].edges.push_back(edge(6, 7));
+  testSet[5].correctIdoms.push_back(-1);
+  testSet[5].correctIdoms.push_back(0);
+  testSet[5].correctIdoms.push_back(0);
+  testSet[5].correctIdoms.push_back(2);
+  testSet[5].correctIdoms.push_back(2);
+  testSet[5].correctIdoms.push_back(-1);
+  testSet[5].correctIdoms.push_back(1);
+  testSet[5].correctIdoms.push_back(0);
+
+  // Cytron's paper, fig. 9
+  testSet[6].numOfVertices = 14,
+  testSet[6].start = 0,
+  testSet[6].edges.push_back(edge(0, 1));
+  testSet[6].edges.push_back(edge(0, 13));
+  testSet[6].edges.push_back(edge(1, 2));
+  testSet[6].edges.push_back(edge(2, 3));
+  testSet[6].edges.push_back(edge(2, 7));
+  testSet[6].edges.push_back(edge(3, 4));
+  testSet[6].edges.push_back(edge(3, 5));
+  testSet[6].edges.push_back(edge(4, 6));
+  testSet[6].edges.push_back(edge(5, 6));
+  testSet[6].edges.push_back(edge(6, 8));
+  testSet[6].edges.push_back(edge(7, 8));
+  testSet[6].edges.push_back(edge(8, 9));
+  testSet[6].edges.push_back(edge(9, 10));
+  testSet[6].edges.push_back(edge(9, 11));
+  testSet[6].edges.push_back(edge(10, 11));
+  testSet[6].edges.push_back(edge(11, 9));
+  testSet[6].edges.push_back(edge(11, 12));
+  testSet[6].edges.push_back(edge(12, 2));
+  testSet[6].edges.push_back(edge(12, 13));
+  testSet[6].correctIdoms.push_back(-1);
+  testSet[6].correctIdoms.push_back(0);
+  testSet[6].correctIdoms.push_back(1);
+  testSet[6].correctIdoms.push_back(2);
+  testSet[6].correctIdoms.push_back(3);
+  testSet[6].correctIdoms.push_back(3);
+  testSet[6].correctIdoms.push_back(3);
+  testSet[6].correctIdoms.push_back(2);
+  testSet[6].correctIdoms.push_back(2);
+  testSet[6].correctIdoms.push_back(8);
+  testSet[6].correctIdoms.push_back(9);
+  testSet[6].correctIdoms.push_back(9);
+  testSet[6].correctIdoms.push_back(11);
+  testSet[6].correctIdoms.push_back(0);
+
+  for (size_t i = 0; i < sizeof(testSet)/sizeof(testSet[0]); ++i) {
+    const int numOfVertices = testSet[i].numOfVertices;
+    Flare::FlareGraph fg;
+    //printf("Starting dominator test\n");
+    for (int j = 0; j < numOfVertices; ++j) {
+        fg.addNode(j);
+    }
+    for (unsigned int j = 0; j < testSet[i].edges.size(); ++j) {
+        fg.addEdge(testSet[i].edges[j].first, testSet[i].edges[j].second);
+    }
+
+    Flare::intintMap_t res;
+    bool ret = fg.idom(res, testSet[i].start);
+    REQUIRE(ret == true);
+    REQUIRE(res.size() == testSet[i].correctIdoms.size());
+    for (unsigned int j = 0; j < testSet[i].correctIdoms.size(); ++j) {
+        REQUIRE(testSet[i].correctIdoms[j] == res[j]);
+    }
+#if 0
+    for (auto it = correctIdoms.begin(); it != correctIdoms.end(); ++it) {
+        printf("correctIdoms[%d] = %d\n", it->first, it->second);
+    }
+    printf("res size: %d\n", res.size());
+    for (auto it = res.begin(); it != res.end(); ++it) {
+        printf("res[%d] = %d\n", it->first, it->second);
+    }
+#endif
+  }
+}
+
+
+TEST_CASE("PostDominator test") {
+    typedef DominatorCorrectnessTestSet::edge edge;
+
+    // http://web.cse.ohio-state.edu/~rountev.1/788/lectures/ControlFlowAnalysis.pdf
+    // slide 13/14
+    DominatorCorrectnessTestSet testSet[3];
+    testSet[0].numOfVertices = 12;
+    testSet[0].start = 11;
+    testSet[0].edges.push_back(edge(0,1));
+    testSet[0].edges.push_back(edge(1,2));
+    testSet[0].edges.push_back(edge(1,3));
+    testSet[0].edges.push_back(edge(2,3));
+    testSet[0].edges.push_back(edge(3,4));
+    testSet[0].edges.push_back(edge(4,3));
+    testSet[0].edges.push_back(edge(4,6));
+    testSet[0].edges.push_back(edge(4,5));
+    testSet[0].edges.push_back(edge(5,7));
+    testSet[0].edges.push_back(edge(6,7));
+    testSet[0].edges.push_back(edge(7,4));
+    testSet[0].edges.push_back(edge(7,8));
+    testSet[0].edges.push_back(edge(8,3));
+    testSet[0].edges.push_back(edge(8,9));
+    testSet[0].edges.push_back(edge(8,10));
+    testSet[0].edges.push_back(edge(9,1));
+    testSet[0].edges.push_back(edge(10,7));
+    testSet[0].edges.push_back(edge(10,11));
+    testSet[0].correctIdoms.push_back(1);
+    testSet[0].correctIdoms.push_back(3);
+    testSet[0].correctIdoms.push_back(3);
+    testSet[0].correctIdoms.push_back(4);
+    testSet[0].correctIdoms.push_back(7);
+    testSet[0].correctIdoms.push_back(7);
+    testSet[0].correctIdoms.push_back(7);
+    testSet[0].correctIdoms.push_back(8);
+    testSet[0].correctIdoms.push_back(10);
+    testSet[0].correctIdoms.push_back(1);
+    testSet[0].correctIdoms.push_back(11);
+    testSet[0].correctIdoms.push_back(-1);
+
+
+    // http://pages.cs.wisc.edu/~fischer/cs701.f08/lectures/Lecture19.4up.pdf
+    // slide 406
+    testSet[1].numOfVertices = 6;
+    testSet[1].start = 5;
+    testSet[1].edges.push_back(edge(0,1));
+    testSet[1].edges.push_back(edge(0,5));
+    testSet[1].edges.push_back(edge(1,2));
+    testSet[1].edges.push_back(edge(1,3));
+    testSet[1].edges.push_back(edge(2,4));
+    testSet[1].edges.push_back(edge(3,4));
+    testSet[1].edges.push_back(edge(4,5));
+    testSet[1].correctIdoms.push_back(5);
+    testSet[1].correctIdoms.push_back(4);
+    testSet[1].correctIdoms.push_back(4);
+    testSet[1].correctIdoms.push_back(4);
+    testSet[1].correctIdoms.push_back(5);
+    testSet[1].correctIdoms.push_back(-1);
+
+    // http://www.cs.kent.edu/~jmaletic/cs63901/lectures/StaticAnalysis.pdf
+    testSet[2].numOfVertices = 7;
+    testSet[2].start = 6;
+    testSet[2].edges.push_back(edge(0,1));
+    testSet[2].edges.push_back(edge(0,2));
+    testSet[2].edges.push_back(edge(1,3));
+    testSet[2].edges.push_back(edge(1,4));
+    testSet[2].edges.push_back(edge(2,4));
+    testSet[2].edges.push_back(edge(2,6));
+    testSet[2].edges.push_back(edge(3,5));
+    testSet[2].edges.push_back(edge(4,5));
+    testSet[2].edges.push_back(edge(5,6));
+    testSet[2].correctIdoms.push_back(6);
+    testSet[2].correctIdoms.push_back(5);
+    testSet[2].correctIdoms.push_back(6);
+    testSet[2].correctIdoms.push_back(5);
+    testSet[2].correctIdoms.push_back(5);
+    testSet[2].correctIdoms.push_back(6);
+    testSet[2].correctIdoms.push_back(-1);
+
+
+    //printf("Starting postdominator test\n");
+
+    for (size_t i = 0; i < sizeof(testSet)/sizeof(testSet[0]); ++i) {
+        //for (unsigned int j = 0; j < testSet[i].correctIdoms.size(); ++j) {
+        //    printf("correctIdoms[%d] = %d\n", j, testSet[i].correctIdoms[j]);
+        //}
+        int correctCount = 0;
+        
+        Flare::FlareGraph fg;
+
+        for (int j = 0; j < testSet[i].numOfVertices; ++j) {
+            fg.addNode(j);
+        }
+        for (unsigned int j = 0; j < testSet[i].edges.size(); ++j) {
+            fg.addEdge(testSet[i].edges[j].first, testSet[i].edges[j].second);
+        }
+        std::ostringstream ostringstr;
+        fg.storeGraphViz(ostringstr);
+        //printf("%d postdom testgraph:\n%s\n", i, ostringstr.str());
+        Flare::intintMap_t res;
+        //printf("Starting ipdom\n");
+        bool ret = fg.ipdom(res, testSet[i].start);
+        REQUIRE(ret == true);
+        REQUIRE(res.size() == testSet[i].correctIdoms.size());
+        //for (auto it = res.begin(); it != res.end(); ++it) {
+        //    printf("res[%d] = %d\n", it->first, it->second);
+        //}
+        for (unsigned int j = 0; j < testSet[i].correctIdoms.size(); ++j) {
+            //REQUIRE(testSet[i].correctIdoms[j] == res[j]);
+            if (testSet[i].correctIdoms[j] == res[j]) {
+                ++correctCount;
+            } else {
+                printf("Incorrect res[%d]: %d vs %d\n", j, testSet[i].correctIdoms[j], res[j]);
+            }
+        }
+        REQUIRE(correctCount == testSet[i].correctIdoms.size());
+    }
+}
+
+
+
+TEST_CASE("PostDominatorGroupTest") {
+
+std::string test1str = R"(
+// file Z:\customer\2017\53142\smartidb_e3c5bd27d02977859acc6ce5570769a8.idb
+// function 20a4c0
+digraph G {
+    0 -> 1
+    0 -> 15
+    1 -> 15
+    1 -> 2
+    10 -> 11
+    10 -> 16
+    11 -> 12
+    12 -> 12
+    12 -> 13
+    13 -> 14
+    13 -> 16
+    14 -> 15
+    2 -> 11
+    2 -> 3
+    3 -> 4
+    4 -> 5
+    4 -> 9
+    5 -> 6
+    5 -> 8
+    6 -> 7
+    6 -> 9
+    7 -> 4
+    7 -> 8
+    8 -> 10
+    9 -> 10
+    4 [ style="filled" fillcolor="green"]
+})";
+
+std::string test1strsolution = R"(digraph G {
+    0 -> 1
+    0 -> 15
+    1 -> 15
+    1 -> 2
+    10 -> 11
+    10 -> 16
+    11 -> 12
+    12 -> 12
+    12 -> 13
+    13 -> 14
+    13 -> 16
+    14 -> 15
+    2 -> 11
+    2 -> 3
+    3 -> 4
+    4 -> 5
+    4 -> 9
+    5 -> 6
+    5 -> 8
+    6 -> 7
+    6 -> 9
+    7 -> 4
+    7 -> 8
+    8 -> 10
+    9 -> 10
+    10 [ style="filled" fillcolor="lightskyblue"]
+    4 [ style="filled" fillcolor="green"]
+    5 [ style="filled" fillcolor="lightskyblue"]
+    6 [ style="filled" fillcolor="lightskyblue"]
+    7 [ style="filled" fillcolor="lightskyblue"]
+    8 [ style="filled" fillcolor="lightskyblue"]
+    9 [ style="filled" fillcolor="lightskyblue"]
+})";
+
+    Flare::FlareGraph fg;
+    std::istringstream istream(test1str);
+    fg.loadGraphViz(istream);
+    Flare::intset_t pdomgroup;
+    bool ret = fg.getpdomGroup(pdomgroup, fg.getRootNode());
+    REQUIRE(ret == true);
+    fg.selectNodes(pdomgroup);
+    std::ostringstream ostringstr;
+    fg.storeGraphViz(ostringstr);
+    //printf("Got output: '%s'\n", ostringstr.str().c_str());
+    REQUIRE(ostringstr.str().c_str() == test1strsolution);
+
+}
+
+TEST_CASE("Frozen CSR graph") {
+    Flare::FlareGraph fg;
+
+    fg.addNode(0);
+    fg.addNode(1);
+    fg.addNode(2);
+    fg.addNode(3);
+    fg.addEdge(0, 1);
+    fg.addEdge(0, 2);
+    fg.addEdge(1, 3);
+    fg.addEdge(2, 3);
+    REQUIRE(fg.frozenValid() == false);
+    REQUIRE(fg.freeze() == true);
+    REQUIRE(fg.frozenValid() == true);
+
+    const Flare::FrozenGraph &fz = fg.getFrozenGraph();
+    REQUIRE(fz.nodeCount() == 4);
+    REQUIRE(fz.edgeCount() == 4);
+    REQUIRE(fz.nsucc(0) == 2);
+    REQUIRE(fz.npred(3) == 2);
+    REQUIRE(fz.succBegin(0)[0] == 1);
+    REQUIRE(fz.succBegin(0)[1] == 2);
+    REQUIRE(fz.predBegin(3)[0] == 1);
+    REQUIRE(fz.predBegin(3)[1] == 2);
+    REQUIRE(fz.nsucc(3) == 0);
+    REQUIRE(fz.npred(0) == 0);
+
+    // the builder path still works after freezing, and the algorithms see the change
+    fg.addNode(4);
+    fg.addEdge(3, 4);
+    REQUIRE(fg.frozenValid() == false);
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    Flare::intset_t out1;
+    REQUIRE(fg.reachable(out1) == true);
+    Flare::intset_t expect1 = { 0, 1, 2, 3, 4 };
+    REQUIRE(out1 == expect1);
+    REQUIRE(fg.frozenValid() == true);
+    REQUIRE(fg.getFrozenGraph().nodeCount() == 5);
+    REQUIRE(fg.getFrozenGraph().edgeCount() == 5);
+}
+
+TEST_CASE("Sparse node names") {
+    Flare::FlareGraph fg;
+
+    // starts out with identity names, then switches to the lookup tables
+    fg.addNode(0);
+    fg.addNode(1);
+    fg.addNode(2);
+    fg.addEdge(0, 1);
+    fg.addEdge(1, 2);
+    REQUIRE(fg.succ(0, 0) == 1);
+    int bigName = 50000000;
+    for (int i = 0; i < 2000; ++i) {
+        fg.addNode(bigName + i * 7919);
+    }
+    REQUIRE(fg.getNodeCount() == 2003);
+    fg.addEdge(2, bigName);
+    for (int i = 1; i < 2000; ++i) {
+        REQUIRE(fg.addEdge(bigName + (i - 1) * 7919, bigName + i * 7919) == true);
+    }
+    // re-adding an existing name returns the same node
+    REQUIRE(fg.addNode(bigName + 7919) == 4);
+    REQUIRE(fg.addNode(1) == 1);
+    REQUIRE(fg.getNodeCount() == 2003);
+
+    REQUIRE(fg.succ(0, 0) == 1);
+    REQUIRE(fg.pred(2, 0) == 1);
+    REQUIRE(fg.succ(2, 0) == bigName);
+    REQUIRE(fg.pred(bigName, 0) == 2);
+    REQUIRE(fg.hasSucc(bigName + 7919, bigName + 2 * 7919));
+    REQUIRE(fg.hasPred(bigName + 7919, bigName + 2 * 7919));
+    REQUIRE(fg.nsucc(bigName + 1999 * 7919) == 0);
+    REQUIRE(fg.nsucc(bigName + 1) == -1);
+    REQUIRE(fg.nsucc(3) == -1);
+
+    fg.addNodeProp(bigName + 1990 * 7919, Flare::NodeProperty::Root);
+    REQUIRE(fg.getRootNode() == bigName + 1990 * 7919);
+    Flare::intset_t out1;
+    REQUIRE(fg.reachable(out1) == true);
+    REQUIRE(out1.size() == 10);
+    REQUIRE(*out1.begin() == bigName + 1990 * 7919);
+    REQUIRE(*out1.rbegin() == bigName + 1999 * 7919);
+}
+
+TEST_CASE("NodeSet bitsets") {
+    // dense layout
+    Flare::NodeSet s1(200);
+    REQUIRE(s1.empty());
+    REQUIRE(s1.insert(3) == true);
+    REQUIRE(s1.insert(3) == false);
+    s1.insert(64);
+    s1.insert(199);
+    REQUIRE(s1.size() == 3);
+    REQUIRE(s1.has(64));
+    REQUIRE(!s1.has(65));
+    REQUIRE(!s1.has(200));
+    REQUIRE(!s1.has(-1));
+
+    Flare::NodeSet s2(200);
+    s2.insert(64);
+    s2.insert(100);
+    s1.subtract(s2);
+    Flare::intset_t out1;
+    s1.toIntset(out1);
+    Flare::intset_t expect1 = { 3, 199 };
+    REQUIRE(out1 == expect1);
+    REQUIRE(s1.size() == 2);
+
+    s1.unite(s2);
+    REQUIRE(s1.size() == 4);
+    REQUIRE(s1.erase(100) == true);
+    REQUIRE(s1.erase(100) == false);
+    REQUIRE(s1.size() == 3);
+
+    // chunked layout for large graphs, chunks are only allocated when used
+    int big = Flare::NODESET_DENSE_LIMIT * 4;
+    Flare::NodeSet s3(big);
+    Flare::NodeSet s4(big);
+    s3.insert(0);
+    s3.insert(big - 1);
+    s3.insert(big / 2);
+    s3.insert(big / 2 + 63);
+    s4.insert(big / 2);
+    REQUIRE(s3.size() == 4);
+    REQUIRE(s3.has(big - 1));
+    REQUIRE(!s3.has(big - 2));
+    s3.subtract(s4);
+    REQUIRE(s3.size() == 3);
+    Flare::intvector_t order;
+    s3.forEach([&order](int n) { order.push_back(n); });
+    Flare::intvector_t expect3 = { 0, big / 2 + 63, big - 1 };
+    REQUIRE(order == expect3);
+    s3.clear();
+    REQUIRE(s3.empty());
+    REQUIRE(!s3.has(0));
+
+    // mismatched universes only touch the words both sets have
+    Flare::NodeSet s5(200);
+    Flare::NodeSet s6(64);
+    s6.insert(5);
+    s6.insert(63);
+    s5.unite(s6);
+    s5.insert(150);
+    REQUIRE(s5.size() == 3);
+    s5.subtract(s6);
+    REQUIRE(s5.size() == 1);
+    REQUIRE(s5.has(150));
+
+    // and the same across the dense and chunked layouts
+    Flare::NodeSet s7(big);
+    s7.insert(big - 1);
+    s7.unite(s6);
+    REQUIRE(s7.size() == 3);
+    Flare::NodeSet s8(big);
+    s8.insert(5);
+    s8.insert(big - 1);
+    s5.insert(5);
+    s5.subtract(s8);
+    REQUIRE(s5.size() == 1);
+    s7.subtract(s5);
+    REQUIRE(s7.size() == 3);
+    s7.subtract(s6);
+    Flare::intvector_t order7;
+    s7.forEach([&order7](int n) { order7.push_back(n); });
+    Flare::intvector_t expect7 = { big - 1 };
+    REQUIRE(order7 == expect7);
+}
+
+// root -> n-2 middle nodes -> sink. the flattened-switch shape that used to go
+// quadratic when the worklists were searched before every push
+static void buildFanOut(Flare::FlareGraph &fg, int n) {
+    for (int i = 0; i < n; ++i) {
+        fg.addNode(i);
+    }
+    for (int i = 1; i < n - 1; ++i) {
+        fg.addEdge(0, i);
+        fg.addEdge(i, n - 1);
+    }
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+}
+
+// runs the traversal based algorithms over a fan-out graph, returns the best of 3 in ms
+static double timeFanOut(int n) {
+    Flare::FlareGraph fg;
+    buildFanOut(fg, n);
+    double best = -1;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        Flare::intset_t r1, r2, r3;
+        Flare::subgraphVec_t subs;
+        fg.reachable(r1);
+        fg.uniqueReachable(r2);
+        fg.getpdomGroup(r3, 0);
+        fg.findSimpleSubGraphs(subs, 0, 100);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        REQUIRE(r1.size() == (size_t)n);
+        REQUIRE(r2.size() == (size_t)n);
+        REQUIRE(r3.size() == (size_t)n);
+        REQUIRE(subs.size() == 1);
+        if ((best < 0) || (ms < best)) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+TEST_CASE("Fan-out traversal scaling", "[.][benchmark]") {
+    double t25k = timeFanOut(25000);
+    double t100k = timeFanOut(100000);
+    printf("fan-out traversal: 25k nodes %.1f ms, 100k nodes %.1f ms (%.2fx)\n", t25k, t100k, t100k / t25k);
+    // 4x the nodes should cost roughly 4x the time. quadratic behavior would be ~16x
+    REQUIRE(t100k < t25k * 8 + 50);
+}
+
+TEST_CASE("Dominators with unreachable nodes") {
+    // 1 -> 2 -> 2 never reaches terminal 4, so nodes 1 and 2 aren't in the
+    // post-dominator tree rooted at 4. 0 still needs its ipdom of 3
+    Flare::FlareGraph fg;
+    for (int i = 0; i < 5; ++i) {
+        fg.addNode(i);
+    }
+    fg.addEdge(2, 2);
+    fg.addEdge(1, 2);
+    fg.addEdge(3, 4);
+    fg.addEdge(0, 1);
+    fg.addEdge(0, 3);
+
+    Flare::intintMap_t res;
+    REQUIRE(fg.ipdom(res, 4) == true);
+    Flare::intintMap_t expect1 = { { 0, 3 }, { 1, -1 }, { 2, -1 }, { 3, 4 }, { 4, -1 } };
+    REQUIRE(res == expect1);
+
+    Flare::intvector_t pdoms;
+    REQUIRE(fg.ipdom(pdoms, 4) == true);
+    Flare::intvector_t expect2 = { 3, -1, -1, 4, -1 };
+    REQUIRE(pdoms == expect2);
+
+    Flare::intvector_t doms;
+    REQUIRE(fg.idom(doms, 1) == true);
+    Flare::intvector_t expect3 = { -1, -1, 1, -1, -1 };
+    REQUIRE(doms == expect3);
+
+    REQUIRE(fg.idom(doms, 7) == false);
+}
+
+TEST_CASE("Virtual exit post-dominators") {
+    // three terminals (4, 5, 6). 7 loops forever, so it stands in as a fourth
+    Flare::FlareGraph fg;
+    for (int i = 0; i < 8; ++i) {
+        fg.addNode(i);
+    }
+    fg.addEdge(0, 1);
+    fg.addEdge(0, 2);
+    fg.addEdge(1, 3);
+    fg.addEdge(2, 3);
+    fg.addEdge(3, 4);
+    fg.addEdge(3, 5);
+    fg.addEdge(1, 6);
+    fg.addEdge(1, 7);
+    fg.addEdge(7, 7);
+
+    Flare::intintMap_t expect = {
+        { 0, Flare::IPDOM_CONFLICT }, { 1, Flare::IPDOM_CONFLICT }, { 2, 3 }, { 3, Flare::IPDOM_CONFLICT },
+        { 4, Flare::IPDOM_UNKNOWN }, { 5, Flare::IPDOM_UNKNOWN }, { 6, Flare::IPDOM_UNKNOWN }, { 7, Flare::IPDOM_UNKNOWN },
+    };
+    REQUIRE(fg.getDomMode() == Flare::DomMode::VirtualRoot);
+    Flare::intintMap_t virt;
+    REQUIRE(fg.getDomIntMap(virt, true) == true);
+    REQUIRE(virt == expect);
+
+    // 2 can't reach 6, so the per-terminal merge gives up on its group
+    Flare::intset_t group;
+    REQUIRE(fg.getpdomGroup(group, 2) == true);
+    Flare::intset_t expectGroup = { 2, 3 };
+    REQUIRE(group == expectGroup);
+    REQUIRE(fg.getpdomGroup(group, 0) == false);
+
+    fg.setDomMode(Flare::DomMode::PerRoot);
+    Flare::intintMap_t merged;
+    REQUIRE(fg.getDomIntMap(merged, true) == true);
+    REQUIRE(merged == expect);
+    Flare::intset_t legacyGroup;
+    REQUIRE(fg.getpdomGroup(legacyGroup, 2) == false);
+}
+
+TEST_CASE("Virtual entry dominators") {
+    // two entries (0 and 8). 8 jumps into the middle of 1's diamond, so
+    // <1,4> stops being a simple subgraph
+    Flare::FlareGraph fg;
+    for (int i = 0; i < 6; ++i) {
+        fg.addNode(i);
+    }
+    fg.addNode(8);
+    fg.addEdge(0, 1);
+    fg.addEdge(1, 2);
+    fg.addEdge(1, 3);
+    fg.addEdge(2, 4);
+    fg.addEdge(3, 4);
+    fg.addEdge(4, 5);
+    fg.addEdge(8, 3);
+
+    Flare::intintMap_t expect = {
+        { 0, Flare::IPDOM_UNKNOWN }, { 1, 0 }, { 2, 1 }, { 3, Flare::IPDOM_CONFLICT },
+        { 4, Flare::IPDOM_CONFLICT }, { 5, 4 }, { 8, Flare::IPDOM_UNKNOWN },
+    };
+    Flare::DomMode modes[] = { Flare::DomMode::VirtualRoot, Flare::DomMode::PerRoot };
+    for (int m = 0; m < 2; ++m) {
+        fg.setDomMode(modes[m]);
+        Flare::intintMap_t doms;
+        REQUIRE(fg.getDomIntMap(doms, false) == true);
+        REQUIRE(doms == expect);
+
+        Flare::subgraphVec_t subs;
+        REQUIRE(fg.findSimpleSubGraphs(subs, 0, 100) == true);
+        REQUIRE(subs.size() == 2);
+        REQUIRE(subs[0].n1 == 0);
+        REQUIRE(subs[0].n2 == 1);
+        REQUIRE(subs[1].n1 == 4);
+        REQUIRE(subs[1].n2 == 5);
+        Flare::intset_t expectNodes = { 4, 5 };
+        REQUIRE(subs[1].nodes == expectNodes);
+    }
+}
+
+TEST_CASE("Cached analyses follow graph changes") {
+    Flare::FlareGraph fg;
+    for (int i = 0; i < 4; ++i) {
+        fg.addNode(i);
+    }
+    fg.addEdge(0, 1);
+    fg.addEdge(0, 2);
+    fg.addEdge(1, 3);
+    fg.addEdge(2, 3);
+
+    Flare::intintMap_t pdoms;
+    REQUIRE(fg.getDomIntMap(pdoms, true) == true);
+    Flare::intintMap_t expect1 = { { 0, 3 }, { 1, 3 }, { 2, 3 }, { 3, Flare::IPDOM_UNKNOWN } };
+    REQUIRE(pdoms == expect1);
+    Flare::intvector_t order;
+    REQUIRE(fg.rpo(order) == true);
+    Flare::intvector_t expectOrder1 = { 0, 2, 1, 3 };
+    REQUIRE(order == expectOrder1);
+
+    // display-only properties leave every cached analysis alone
+    unsigned int structureGen = fg.getStructureGeneration();
+    unsigned int rootsGen = fg.getRootsGeneration();
+    fg.addNodeProp(1, Flare::NodeProperty::Selected);
+    REQUIRE(fg.getStructureGeneration() == structureGen);
+    REQUIRE(fg.getRootsGeneration() == rootsGen);
+
+    // the root and sentries only invalidate the reachability results
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    REQUIRE(fg.getStructureGeneration() == structureGen);
+    REQUIRE(fg.getRootsGeneration() != rootsGen);
+    Flare::intset_t ureach;
+    REQUIRE(fg.uniqueReachable(ureach) == true);
+    Flare::intset_t expectReach1 = { 0, 1, 2, 3 };
+    REQUIRE(ureach == expectReach1);
+    fg.addNodeProp(2, Flare::NodeProperty::Sentry);
+    ureach.clear();
+    REQUIRE(fg.uniqueReachable(ureach) == true);
+    Flare::intset_t expectReach2 = { 0, 1 };
+    REQUIRE(ureach == expectReach2);
+
+    // a new terminal changes everything
+    fg.addNode(4);
+    fg.addEdge(1, 4);
+    REQUIRE(fg.getStructureGeneration() != structureGen);
+    pdoms.clear();
+    REQUIRE(fg.getDomIntMap(pdoms, true) == true);
+    Flare::intintMap_t expect2 = {
+        { 0, Flare::IPDOM_CONFLICT }, { 1, Flare::IPDOM_CONFLICT }, { 2, 3 }, { 3, Flare::IPDOM_UNKNOWN }, { 4, Flare::IPDOM_UNKNOWN },
+    };
+    REQUIRE(pdoms == expect2);
+    ureach.clear();
+    REQUIRE(fg.uniqueReachable(ureach) == true);
+    Flare::intset_t expectReach3 = { 0, 1, 4 };
+    REQUIRE(ureach == expectReach3);
+    REQUIRE(fg.rpo(order) == true);
+    Flare::intvector_t expectOrder2 = { 0, 2, 1, 4, 3 };
+    REQUIRE(order == expectOrder2);
+}
+
+// depth+1 nested diamonds: head 3i branches to 3i+1 and to the next level's head
+// (the last level goes straight to its join), and both sides meet at 3i+2. every
+// <3i,3i+2> is a simple subgraph holding all deeper levels
+static void buildNested(Flare::FlareGraph &fg, int depth) {
+    for (int i = 0; i <= depth; ++i) {
+        fg.addNode(3 * i);
+        fg.addNode(3 * i + 1);
+        fg.addNode(3 * i + 2);
+    }
+    for (int i = 0; i <= depth; ++i) {
+        if (i < depth) {
+            fg.addEdge(3 * i, 3 * (i + 1));
+            fg.addEdge(3 * (i + 1) + 2, 3 * i + 2);
+        } else {
+            fg.addEdge(3 * i, 3 * i + 2);
+        }
+        fg.addEdge(3 * i, 3 * i + 1);
+        fg.addEdge(3 * i + 1, 3 * i + 2);
+    }
+}
+
+TEST_CASE("Nested simple subgraphs") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 20);
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+
+    Flare::subgraphVec_t regions;
+    REQUIRE(fg.findSimpleSubGraphs(regions, 0, 100) == true);
+    REQUIRE(regions.size() == 21);
+    for (int i = 0; i <= 20; ++i) {
+        REQUIRE(regions[i].n1 == 3 * i);
+        REQUIRE(regions[i].n2 == 3 * i + 2);
+        REQUIRE(regions[i].nodes.size() == (size_t)(3 * (21 - i)));
+    }
+
+    // the size limits drop the outer levels
+    Flare::subgraphVec_t small;
+    REQUIRE(fg.findSimpleSubGraphs(small, 4, 20) == true);
+    REQUIRE(small.size() == 3);
+    REQUIRE(small[0].n1 == 51);
+
+    fg.setDomMode(Flare::DomMode::PerRoot);
+    Flare::subgraphVec_t verified;
+    REQUIRE(fg.findSimpleSubGraphs(verified, 0, 100) == true);
+    REQUIRE(verified.size() == regions.size());
+    for (size_t i = 0; i < verified.size(); ++i) {
+        REQUIRE(verified[i].nodes == regions[i].nodes);
+    }
+
+    // an edge from level 0 into the middle of level 10 breaks levels 1..10
+    fg.addEdge(1, 31);
+    fg.setDomMode(Flare::DomMode::VirtualRoot);
+    regions.clear();
+    REQUIRE(fg.findSimpleSubGraphs(regions, 0, 100) == true);
+    REQUIRE(regions.size() == 11);
+    REQUIRE(regions[0].n1 == 0);
+    REQUIRE(regions[1].n1 == 33);
+}
+
+TEST_CASE("Nested subgraph scaling", "[.][benchmark]") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 5000);
+    Flare::DomMode modes[] = { Flare::DomMode::PerRoot, Flare::DomMode::VirtualRoot };
+    double ms[2];
+    size_t found[2];
+    for (int m = 0; m < 2; ++m) {
+        fg.setDomMode(modes[m]);
+        Flare::subgraphVec_t regions;
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(fg.findSimpleSubGraphs(regions, 3, 1) == true);
+        ms[m] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        found[m] = regions.size();
+    }
+    printf("nested subgraphs, 15k nodes: per-candidate verify %.1f ms, single pass %.1f ms\n", ms[0], ms[1]);
+    REQUIRE(found[0] == found[1]);
+}
+
+TEST_CASE("Region tree") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 20);
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+
+    Flare::RegionTree tree;
+    REQUIRE(fg.findRegionTree(tree, 0, 100) == true);
+    REQUIRE(tree.size() == 21);
+    REQUIRE(tree.childEnd(-1) - tree.childBegin(-1) == 1);
+    REQUIRE(*tree.childBegin(-1) == 0);
+
+    Flare::subgraphVec_t flat;
+    REQUIRE(fg.findSimpleSubGraphs(flat, 0, 100) == true);
+    REQUIRE(flat.size() == 21);
+
+    for (int i = 0; i <= 20; ++i) {
+        const Flare::RegionTree::region_t &reg = tree.region(i);
+        REQUIRE(reg.n1 == 3 * i);
+        REQUIRE(reg.n2 == 3 * i + 2);
+        REQUIRE(reg.parent == i - 1);
+        REQUIRE(reg.depth == i);
+        REQUIRE(tree.nodeCount(i) == 3 * (21 - i));
+        REQUIRE(tree.childEnd(i) - tree.childBegin(i) == (i < 20 ? 1 : 0));
+
+        // the child levels are only in their own region
+        Flare::intset_t own(tree.ownBegin(i), tree.ownEnd(i));
+        Flare::intset_t expected = { 3 * i, 3 * i + 1, 3 * i + 2 };
+        REQUIRE(own == expected);
+
+        Flare::intset_t nodes;
+        tree.getNodes(i, nodes);
+        REQUIRE(nodes == flat[i].nodes);
+        REQUIRE(tree.contains(i, 3 * i + 1) == true);
+        REQUIRE(tree.contains(i, 62) == true);
+        REQUIRE(tree.contains(i, 3 * i - 2) == false);
+    }
+
+    // a chain is three sibling regions sharing their boundary nodes
+    Flare::FlareGraph chain;
+    for (int i = 0; i < 4; ++i) {
+        chain.addNode(i);
+    }
+    chain.addEdge(0, 1);
+    chain.addEdge(1, 2);
+    chain.addEdge(2, 3);
+    chain.addNodeProp(0, Flare::NodeProperty::Root);
+    REQUIRE(chain.findRegionTree(tree, 0, 100) == true);
+    REQUIRE(tree.size() == 3);
+    REQUIRE(tree.childEnd(-1) - tree.childBegin(-1) == 3);
+    for (int r = 0; r < 3; ++r) {
+        REQUIRE(tree.region(r).parent == -1);
+        REQUIRE(tree.nodeCount(r) == 2);
+        REQUIRE(tree.ownEnd(r) - tree.ownBegin(r) == 2);
+    }
+    REQUIRE(tree.contains(0, 1) == true);
+    REQUIRE(tree.contains(1, 1) == true);
+    REQUIRE(tree.contains(0, 2) == false);
+}
+
+TEST_CASE("Unique reachable against a brute force cut") {
+    // small random graphs. a node is uniquely reachable when it is reachable from the
+    // root and no path from a node outside the reachable set gets to it without
+    // going through the root
+    unsigned int seed = 12345;
+    auto next = [&seed](int mod) {
+        seed = seed * 1103515245 + 12345;
+        return (int)((seed >> 16) % mod);
+    };
+    for (int iter = 0; iter < 300; ++iter) {
+        int n = 4 + next(20);
+        std::vector<Flare::intvector_t> succs(n);
+        Flare::FlareGraph fg;
+        for (int i = 0; i < n; ++i) {
+            fg.addNode(i);
+        }
+        int edges = n + next(2 * n);
+        for (int e = 0; e < edges; ++e) {
+            int u = next(n);
+            int v = next(n);
+            succs[u].push_back(v);
+            fg.addEdge(u, v);
+        }
+        int root = next(n);
+        fg.addNodeProp(root, Flare::NodeProperty::Root);
+        std::vector<bool> sentry(n, false);
+        for (int s = next(3); s > 0; --s) {
+            int x = next(n);
+            if (x != root) {
+                sentry[x] = true;
+                fg.addNodeProp(x, Flare::NodeProperty::Sentry);
+            }
+        }
+
+        std::vector<bool> reach(n, false);
+        Flare::intvector_t stack = { root };
+        reach[root] = true;
+        while (!stack.empty()) {
+            int u = stack.back();
+            stack.pop_back();
+            for (int v : succs[u]) {
+                if (!reach[v] && !sentry[v]) {
+                    reach[v] = true;
+                    stack.push_back(v);
+                }
+            }
+        }
+        std::vector<bool> around(n, false);
+        for (int i = 0; i < n; ++i) {
+            if (!reach[i]) {
+                around[i] = true;
+                stack.push_back(i);
+            }
+        }
+        while (!stack.empty()) {
+            int u = stack.back();
+            stack.pop_back();
+            for (int v : succs[u]) {
+                if (!around[v] && v != root) {
+                    around[v] = true;
+                    stack.push_back(v);
+                }
+            }
+        }
+        Flare::intset_t expect;
+        for (int i = 0; i < n; ++i) {
+            if (reach[i] && !around[i]) {
+                expect.insert(i);
+            }
+        }
+
+        Flare::intset_t ureach;
+        REQUIRE(fg.uniqueReachable(ureach) == true);
+        REQUIRE(ureach == expect);
+    }
+}
+
+TEST_CASE("Unique reachable scaling", "[.][benchmark]") {
+    // 30k node ladder where every other rung is entered from a node outside
+    Flare::FlareGraph fg;
+    int n = 30000;
+    for (int i = 0; i <= n; ++i) {
+        fg.addNode(i);
+    }
+    for (int i = 0; i + 2 < n; ++i) {
+        fg.addEdge(i, i + 1);
+        fg.addEdge(i, i + 2);
+    }
+    for (int i = n / 2; i < n; i += 2) {
+        fg.addEdge(n, i);
+    }
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    auto start = std::chrono::steady_clock::now();
+    Flare::intset_t ureach;
+    REQUIRE(fg.uniqueReachable(ureach) == true);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("unique reachable, 30k nodes: %.1f ms\n", ms);
+    REQUIRE(ureach.size() == (size_t)(n / 2));
+}
+
+TEST_CASE("Unique reachable for switch cases") {
+    // every case in one pass has to match moving the root to each case in turn
+    unsigned int seed = 777;
+    auto next = [&seed](int mod) {
+        seed = seed * 1103515245 + 12345;
+        return (int)((seed >> 16) % mod);
+    };
+    for (int iter = 0; iter < 300; ++iter) {
+        int n = 4 + next(24);
+        Flare::FlareGraph fg;
+        for (int i = 0; i < n; ++i) {
+            fg.addNode(10 * i);
+        }
+        int dispatcher = next(n);
+        for (int c = next(8); c > 0; --c) {
+            fg.addEdge(10 * dispatcher, 10 * next(n));
+        }
+        for (int e = n + next(n); e > 0; --e) {
+            fg.addEdge(10 * next(n), 10 * next(n));
+        }
+        for (int s = next(3); s > 0; --s) {
+            fg.addNodeProp(10 * next(n), Flare::NodeProperty::Sentry);
+        }
+        int root = 10 * next(n);
+        fg.addNodeProp(root, Flare::NodeProperty::Root);
+
+        Flare::intsetMap_t cases;
+        unsigned int rootsGen = fg.getRootsGeneration();
+        REQUIRE(fg.uniqueReachableCases(10 * dispatcher, cases) == true);
+        REQUIRE(fg.getRootNode() == root);
+        // the query leaves the node properties, and with them the cached results, alone
+        REQUIRE(fg.getRootsGeneration() == rootsGen);
+        Flare::intset_t succs;
+        for (int i = 0; i < fg.nsucc(10 * dispatcher); ++i) {
+            succs.insert(fg.succ(10 * dispatcher, i));
+        }
+        REQUIRE(cases.size() == succs.size());
+        for (auto it = cases.begin(); it != cases.end(); ++it) {
+            fg.clearNodeProp(fg.getRootNode(), Flare::NodeProperty::Root);
+            fg.addNodeProp(it->first, Flare::NodeProperty::Root);
+            Flare::intset_t ureach;
+            REQUIRE(fg.uniqueReachable(ureach) == true);
+            REQUIRE(ureach == it->second);
+        }
+        fg.clearNodeProp(fg.getRootNode(), Flare::NodeProperty::Root);
+        fg.addNodeProp(root, Flare::NodeProperty::Root);
+    }
+}
+
+TEST_CASE("Switch case scaling", "[.][benchmark]") {
+    // dispatcher 0 with 2000 cases of 10 blocks each, all joining at a shared
+    // exit followed by a 10k block tail that every case reaches
+    int cases = 2000;
+    int caseLen = 10;
+    int exitNode = cases * caseLen + 1;
+    int tail = 10000;
+    Flare::FlareGraph fg;
+    for (int i = 0; i <= exitNode + tail; ++i) {
+        fg.addNode(i);
+    }
+    for (int i = exitNode; i < exitNode + tail; ++i) {
+        fg.addEdge(i, i + 1);
+    }
+    for (int c = 0; c < cases; ++c) {
+        int first = c * caseLen + 1;
+        fg.addEdge(0, first);
+        for (int i = first; i < first + caseLen - 1; ++i) {
+            fg.addEdge(i, i + 1);
+        }
+        fg.addEdge(first + caseLen - 1, exitNode);
+    }
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    auto start = std::chrono::steady_clock::now();
+    Flare::intsetMap_t groups;
+    REQUIRE(fg.uniqueReachableCases(0, groups) == true);
+    double batched = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int c = 0; c < cases; ++c) {
+        fg.clearNodeProp(fg.getRootNode(), Flare::NodeProperty::Root);
+        fg.addNodeProp(c * caseLen + 1, Flare::NodeProperty::Root);
+        Flare::intset_t ureach;
+        REQUIRE(fg.uniqueReachable(ureach) == true);
+        REQUIRE(ureach == groups[c * caseLen + 1]);
+    }
+    double single = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("switch cases, %d cases: one root at a time %.1f ms, batched %.1f ms\n", cases, single, batched);
+    REQUIRE(groups.size() == (size_t)cases);
+}
+
+TEST_CASE("Traversal templates") {
+    //  0 -> 1 -> 3 -> 4
+    //  0 -> 2 -> 3
+    //  5 -> 2
+    Flare::FlareGraph fg;
+    for (int i = 0; i < 6; ++i) {
+        fg.addNode(i);
+    }
+    fg.addEdge(0, 1);
+    fg.addEdge(0, 2);
+    fg.addEdge(1, 3);
+    fg.addEdge(2, 3);
+    fg.addEdge(3, 4);
+    fg.addEdge(5, 2);
+    const Flare::FrozenGraph &g = fg.getFrozenGraph();
+
+    // walking predecessors needs no reversed copy of the graph
+    Flare::NodeSet seen(6);
+    Flare::intvector_t stack = { 3 };
+    REQUIRE(Flare::walk<Flare::PredDir>(g, stack, seen, Flare::AllNodes(), Flare::NoVisit()) == 5);
+    REQUIRE(!seen.has(4));
+
+    // sentry-style filter
+    Flare::NodeSet blocked(6);
+    blocked.insert(2);
+    seen.clear();
+    stack = { 0 };
+    Flare::intvector_t visited;
+    Flare::walk<Flare::SuccDir>(g, stack, seen, Flare::SkipNodes(blocked), [&visited](int n) { visited.push_back(n); });
+    std::sort(visited.begin(), visited.end());
+    Flare::intvector_t expectWalk = { 0, 1, 3, 4 };
+    REQUIRE(visited == expectWalk);
+
+    // induced subgraph, breadth first
+    Flare::NodeSet members(6);
+    members.insert(0);
+    members.insert(2);
+    members.insert(3);
+    members.insert(5);
+    seen.clear();
+    Flare::intvector_t queue = { 0, 5 };
+    REQUIRE(Flare::bfs<Flare::SuccDir>(g, queue, seen, Flare::OnlyNodes(members), Flare::NoVisit()) == 4);
+    Flare::intvector_t expectBfs = { 0, 5, 2, 3 };
+    REQUIRE(queue == expectBfs);
+
+    // preorder with tree parents, and postorder
+    seen.clear();
+    Flare::dfsStack_t dfsStack;
+    Flare::intvector_t preorder, parents, postorder;
+    Flare::dfs<Flare::SuccDir>(g, 0, dfsStack, seen, Flare::AllNodes(),
+        [&](int n, int from) { preorder.push_back(n); parents.push_back(from); },
+        [&](int n) { postorder.push_back(n); });
+    Flare::intvector_t expectPre = { 0, 1, 3, 4, 2 };
+    Flare::intvector_t expectParents = { -1, 0, 1, 3, 0 };
+    Flare::intvector_t expectPost = { 4, 3, 1, 2, 0 };
+    REQUIRE(preorder == expectPre);
+    REQUIRE(parents == expectParents);
+    REQUIRE(postorder == expectPost);
+
+    // the public rpo() is built on the same dfs, from entries 0 and 5
+    Flare::intvector_t order;
+    REQUIRE(fg.rpo(order) == true);
+    Flare::intvector_t expectRpo = { 5, 0, 2, 1, 3, 4 };
+    REQUIRE(order == expectRpo);
+}
+
+TEST_CASE("Strongly connected components") {
+    //  0 -> 1 -> 2 -> 1,  2 -> 3 -> 4 -> 3,  4 -> 5,  6 -> 6
+    Flare::FlareGraph fg;
+    for (int i = 0; i < 7; ++i) {
+        fg.addNode(i);
+    }
+    fg.addEdge(0, 1);
+    fg.addEdge(1, 2);
+    fg.addEdge(2, 1);
+    fg.addEdge(2, 3);
+    fg.addEdge(3, 4);
+    fg.addEdge(4, 3);
+    fg.addEdge(4, 5);
+    fg.addEdge(6, 6);
+
+    Flare::intvector_t comp;
+    REQUIRE(fg.stronglyConnectedComponents(comp) == 5);
+    REQUIRE(comp.size() == 7);
+    REQUIRE(comp[1] == comp[2]);
+    REQUIRE(comp[3] == comp[4]);
+    REQUIRE(comp[1] != comp[3]);
+    // successors come first
+    REQUIRE(comp[5] < comp[3]);
+    REQUIRE(comp[3] < comp[1]);
+    REQUIRE(comp[1] < comp[0]);
+
+    // a long chain folded into one cycle must not recurse
+    Flare::FlareGraph ring;
+    int n = 200000;
+    for (int i = 0; i < n; ++i) {
+        ring.addNode(i);
+    }
+    for (int i = 0; i < n; ++i) {
+        ring.addEdge(i, (i + 1) % n);
+    }
+    REQUIRE(ring.stronglyConnectedComponents(comp) == 1);
+}
+
+TEST_CASE("Loop nesting forest") {
+    //  0 -> 1 -> 2 -> 3 -> 2      inner loop {2,3}
+    //            3 -> 4 -> 1      outer loop {1,2,3,4}
+    //            4 -> 5 -> 5      self loop {5}
+    //            5 -> 6
+    Flare::FlareGraph fg;
+    for (int i = 0; i < 7; ++i) {
+        fg.addNode(i);
+    }
+    fg.addEdge(0, 1);
+    fg.addEdge(1, 2);
+    fg.addEdge(2, 3);
+    fg.addEdge(3, 2);
+    fg.addEdge(3, 4);
+    fg.addEdge(4, 1);
+    fg.addEdge(4, 5);
+    fg.addEdge(5, 5);
+    fg.addEdge(5, 6);
+
+    Flare::LoopForest forest;
+    REQUIRE(fg.findLoopForest(forest) == true);
+    REQUIRE(forest.size() == 3);
+    REQUIRE(forest.childEnd(-1) - forest.childBegin(-1) == 2);
+
+    int outer = forest.loopOf(1);
+    int inner = forest.loopOf(3);
+    int self = forest.loopOf(5);
+    REQUIRE(forest.loop(outer).header == 1);
+    REQUIRE(forest.loop(outer).depth == 0);
+    REQUIRE(forest.loop(inner).header == 2);
+    REQUIRE(forest.loop(inner).parent == outer);
+    REQUIRE(forest.loop(inner).depth == 1);
+    REQUIRE(forest.loop(self).header == 5);
+    REQUIRE(forest.loop(self).parent == -1);
+    REQUIRE(forest.loopOf(0) == -1);
+    REQUIRE(forest.loopOf(6) == -1);
+    REQUIRE(forest.loop(outer).reducible == true);
+
+    Flare::intset_t nodes;
+    forest.getNodes(outer, nodes);
+    Flare::intset_t expectOuter = { 1, 2, 3, 4 };
+    REQUIRE(nodes == expectOuter);
+    REQUIRE(forest.nodeCount(inner) == 2);
+    REQUIRE(*forest.bodyBegin(inner) == 2);
+    REQUIRE(forest.bodyEnd(outer) - forest.bodyBegin(outer) == 2);
+    REQUIRE(forest.contains(outer, 3) == true);
+    REQUIRE(forest.contains(inner, 4) == false);
+
+    // two ways into a cycle: 0 -> 1 <-> 2 <- 0
+    Flare::FlareGraph irr;
+    for (int i = 0; i < 3; ++i) {
+        irr.addNode(i);
+    }
+    irr.addEdge(0, 1);
+    irr.addEdge(0, 2);
+    irr.addEdge(1, 2);
+    irr.addEdge(2, 1);
+    REQUIRE(irr.findLoopForest(forest) == true);
+    REQUIRE(forest.size() == 1);
+    REQUIRE(forest.loop(0).reducible == false);
+    REQUIRE(forest.nodeCount(0) == 2);
+
+    // a function that never returns still has its loops found
+    Flare::FlareGraph spin;
+    for (int i = 0; i < 3; ++i) {
+        spin.addNode(i);
+    }
+    spin.addEdge(0, 1);
+    spin.addEdge(1, 2);
+    spin.addEdge(2, 1);
+    REQUIRE(spin.findLoopForest(forest) == true);
+    REQUIRE(forest.size() == 1);
+    REQUIRE(forest.loop(0).header == 1);
+}
+
+TEST_CASE("Loop forest scaling", "[.][benchmark]") {
+    // a 600k block chain where block n-1-i jumps back to block i: 300k loops
+    // nested inside each other, about a million edges
+    Flare::FlareGraph fg;
+    int n = 600000;
+    int levels = n / 2;
+    for (int i = 0; i < n; ++i) {
+        fg.addNode(i);
+    }
+    for (int i = 0; i + 1 < n; ++i) {
+        fg.addEdge(i, i + 1);
+    }
+    for (int i = 0; i < levels; ++i) {
+        fg.addEdge(n - 1 - i, i);
+    }
+    auto start = std::chrono::steady_clock::now();
+    Flare::intvector_t comp;
+    int components = fg.stronglyConnectedComponents(comp);
+    double sccMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    Flare::LoopForest forest;
+    REQUIRE(fg.findLoopForest(forest) == true);
+    double loopMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("1M edges: scc %.1f ms, loop forest %.1f ms\n", sccMs, loopMs);
+    REQUIRE(components == 1);
+    REQUIRE(forest.size() == levels);
+    REQUIRE(forest.loop(levels - 1).depth == levels - 1);
+}
+
+TEST_CASE("Post-dominators without terminals") {
+    // a dispatcher loop that never returns. the loop has no exit, so its
+    // deepest node (4) stands in as the terminal
+    Flare::FlareGraph fg;
+    for (int i = 0; i < 5; ++i) {
+        fg.addNode(i);
+    }
+    fg.addEdge(0, 1);
+    fg.addEdge(1, 2);
+    fg.addEdge(1, 3);
+    fg.addEdge(2, 4);
+    fg.addEdge(3, 4);
+    fg.addEdge(4, 1);
+
+    Flare::intintMap_t expect = {
+        { 0, 1 }, { 1, 4 }, { 2, 4 }, { 3, 4 }, { 4, Flare::IPDOM_UNKNOWN },
+    };
+    Flare::DomMode modes[] = { Flare::DomMode::VirtualRoot, Flare::DomMode::PerRoot };
+    for (int m = 0; m < 2; ++m) {
+        fg.setDomMode(modes[m]);
+        Flare::intintMap_t pdoms;
+        REQUIRE(fg.getDomIntMap(pdoms, true) == true);
+        REQUIRE(pdoms == expect);
+
+        Flare::intset_t group;
+        REQUIRE(fg.getpdomGroup(group, 1) == true);
+        Flare::intset_t expectGroup = { 1, 2, 3, 4 };
+        REQUIRE(group == expectGroup);
+
+        Flare::subgraphVec_t subs;
+        REQUIRE(fg.findSimpleSubGraphs(subs, 0, 100) == true);
+        REQUIRE(subs.empty() == false);
+    }
+
+    // a closed loop with no way in gets a stand-in entry as well
+    Flare::FlareGraph ring;
+    for (int i = 0; i < 3; ++i) {
+        ring.addNode(i);
+    }
+    for (int i = 0; i < 3; ++i) {
+        ring.addEdge(i, (i + 1) % 3);
+    }
+    Flare::intintMap_t doms;
+    REQUIRE(ring.getDomIntMap(doms, false) == true);
+    Flare::intintMap_t expectDoms = { { 0, Flare::IPDOM_UNKNOWN }, { 1, 0 }, { 2, 1 } };
+    REQUIRE(doms == expectDoms);
+    REQUIRE(ring.getDomIntMap(doms, true) == true);
+    Flare::intintMap_t expectPdoms = { { 0, 1 }, { 1, 2 }, { 2, Flare::IPDOM_UNKNOWN } };
+    REQUIRE(doms == expectPdoms);
+
+    // a function that returns through 5 but also has a closed loop 2-3-4. only
+    // the real return is an exit, so <1,5> is still a region
+    Flare::FlareGraph mixed;
+    for (int i = 0; i < 6; ++i) {
+        mixed.addNode(i);
+    }
+    mixed.addEdge(0, 1);
+    mixed.addEdge(1, 2);
+    mixed.addEdge(1, 5);
+    mixed.addEdge(2, 3);
+    mixed.addEdge(3, 4);
+    mixed.addEdge(4, 2);
+    for (int m = 0; m < 2; ++m) {
+        mixed.setDomMode(modes[m]);
+        Flare::intset_t group;
+        REQUIRE(mixed.getpdomGroup(group, 1) == true);
+        Flare::intset_t expectGroup = { 1, 2, 3, 4, 5 };
+        REQUIRE(group == expectGroup);
+
+        Flare::subgraphVec_t subs;
+        REQUIRE(mixed.findSimpleSubGraphs(subs, 0, 100) == true);
+        bool found = false;
+        for (size_t i = 0; i < subs.size(); ++i) {
+            found = found || ((subs[i].n1 == 1) && (subs[i].n2 == 5));
+        }
+        REQUIRE(found);
+    }
+}
+
+TEST_CASE("Threaded subgraph verification") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 400);
+    // cross edges break some of the levels, so candidates fail in between ones that pass
+    unsigned int seed = 7;
+    for (int i = 0; i < 40; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int from = (seed >> 16) % 1200;
+        seed = seed * 1103515245 + 12345;
+        fg.addEdge(from, (seed >> 16) % 1200);
+    }
+    fg.setDomMode(Flare::DomMode::PerRoot);
+
+    fg.setThreadCount(1);
+    Flare::subgraphVec_t serial;
+    REQUIRE(fg.findSimpleSubGraphs(serial, 0, 100) == true);
+    REQUIRE(serial.size() > 10);
+
+    unsigned int counts[] = { 2, 7, 0 };
+    for (int c = 0; c < 3; ++c) {
+        fg.setThreadCount(counts[c]);
+        REQUIRE(fg.getThreadCount() == counts[c]);
+        Flare::subgraphVec_t threaded;
+        REQUIRE(fg.findSimpleSubGraphs(threaded, 0, 100) == true);
+        REQUIRE(threaded.size() == serial.size());
+        for (size_t i = 0; i < serial.size(); ++i) {
+            REQUIRE(threaded[i].n1 == serial[i].n1);
+            REQUIRE(threaded[i].n2 == serial[i].n2);
+            REQUIRE(threaded[i].nodes == serial[i].nodes);
+        }
+    }
+}
+
+TEST_CASE("Threaded verification scaling", "[.][benchmark]") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 5000);
+    fg.setDomMode(Flare::DomMode::PerRoot);
+    unsigned int counts[] = { 1, 0 };
+    double ms[2];
+    size_t found[2];
+    for (int c = 0; c < 2; ++c) {
+        fg.setThreadCount(counts[c]);
+        Flare::subgraphVec_t regions;
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(fg.findSimpleSubGraphs(regions, 3, 1) == true);
+        ms[c] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        found[c] = regions.size();
+    }
+    printf("per-candidate verify, 15k nodes: 1 thread %.1f ms, %u threads %.1f ms\n", ms[0], std::thread::hardware_concurrency(), ms[1]);
+    REQUIRE(found[0] == found[1]);
+}
+
+TEST_CASE("Dominance index") {
+    // dominates() against the idom chains of getDomIntMap() on random graphs
+    unsigned int seed = 11;
+    for (int iter = 0; iter < 50; ++iter) {
+        Flare::FlareGraph fg;
+        int count = 5 + iter % 20;
+        for (int i = 0; i < count; ++i) {
+            fg.addNode(i);
+        }
+        Flare::intvector_t degree[2] = { Flare::intvector_t(count, 0), Flare::intvector_t(count, 0) };
+        for (int i = 0; i < count * 3 / 2; ++i) {
+            seed = seed * 1103515245 + 12345;
+            int from = (seed >> 16) % count;
+            seed = seed * 1103515245 + 12345;
+            int to = (seed >> 16) % count;
+            if (!fg.hasSucc(from, to)) {
+                fg.addEdge(from, to);
+                ++degree[0][to];
+                ++degree[1][from];
+            }
+        }
+        for (int p = 0; p < 2; ++p) {
+            bool post = (p == 1);
+            Flare::intintMap_t doms;
+            REQUIRE(fg.getDomIntMap(doms, post) == true);
+            // stand-in roots are only used when no node is a real one. otherwise a
+            // node whose idom chain doesn't end at a root is in no tree at all
+            bool realRoots = std::count(degree[p].begin(), degree[p].end(), 0) > 0;
+            for (int a = 0; a < count; ++a) {
+                int dominated = 0;
+                for (int b = 0; b < count; ++b) {
+                    bool expect = false;
+                    int x = b;
+                    for (; doms[x] >= 0; x = doms[x]) {
+                        expect = expect || (x == a);
+                    }
+                    expect = expect || (x == a);
+                    if (realRoots && (doms[x] == Flare::IPDOM_UNKNOWN) && (degree[p][x] != 0)) {
+                        expect = false;
+                    }
+                    REQUIRE(fg.dominates(a, b, post) == expect);
+                    dominated += expect ? 1 : 0;
+                }
+                REQUIRE(fg.dominatedCount(a, post) == dominated);
+            }
+        }
+    }
+
+    Flare::FlareGraph fg;
+    fg.addNode(0);
+    fg.addNode(1);
+    fg.addEdge(0, 1);
+    REQUIRE(fg.dominates(0, 1, false) == true);
+    REQUIRE(fg.dominates(1, 0, false) == false);
+    REQUIRE(fg.dominates(1, 0, true) == true);
+    REQUIRE(fg.dominates(0, 5, false) == false);
+    REQUIRE(fg.dominatedCount(5, false) == 0);
+    REQUIRE(fg.dominatedCount(0, false) == 2);
+}
+
+TEST_CASE("Smallest enclosing region") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 5);
+    Flare::subgraph_t region(-1, -1);
+    Flare::intset_t nodes = { 7, 8 };
+    REQUIRE(fg.findEnclosingRegion(nodes, region, 0, 100) == true);
+    REQUIRE(region.n1 == 6);
+    REQUIRE(region.n2 == 8);
+
+    // nodes from two levels need the outer one
+    nodes.insert(4);
+    REQUIRE(fg.findEnclosingRegion(nodes, region, 0, 100) == true);
+    REQUIRE(region.n1 == 3);
+    REQUIRE(region.n2 == 5);
+    REQUIRE(region.nodes.size() == 15);
+
+    Flare::intset_t unknown = { 4, 99 };
+    REQUIRE(fg.findEnclosingRegion(unknown, region, 0, 100) == false);
+
+    // against the smallest of all findSimpleSubGraphs() regions holding the nodes
+    unsigned int seed = 5;
+    for (int iter = 0; iter < 200; ++iter) {
+        Flare::FlareGraph rg;
+        int count = 6 + iter % 25;
+        for (int i = 0; i < count; ++i) {
+            rg.addNode(i);
+        }
+        for (int i = 0; i + 1 < count; ++i) {
+            seed = seed * 1103515245 + 12345;
+            int to = i + 1 + (seed >> 16) % 3;
+            rg.addEdge(i, to < count ? to : count - 1);
+        }
+        for (int i = 0; i < count / 4; ++i) {
+            seed = seed * 1103515245 + 12345;
+            int from = (seed >> 16) % count;
+            seed = seed * 1103515245 + 12345;
+            int to = (seed >> 16) % count;
+            if (!rg.hasSucc(from, to)) {
+                rg.addEdge(from, to);
+            }
+        }
+        Flare::subgraphVec_t all;
+        REQUIRE(rg.findSimpleSubGraphs(all, 0, 100) == true);
+        for (int q = 0; q < 10; ++q) {
+            Flare::intset_t pick;
+            seed = seed * 1103515245 + 12345;
+            int k = 1 + (seed >> 16) % 3;
+            for (int j = 0; j < k; ++j) {
+                seed = seed * 1103515245 + 12345;
+                pick.insert((seed >> 16) % count);
+            }
+            size_t expect = 0;
+            for (size_t r = 0; r < all.size(); ++r) {
+                if (std::includes(all[r].nodes.begin(), all[r].nodes.end(), pick.begin(), pick.end()) &&
+                    ((expect == 0) || (all[r].nodes.size() < expect))) {
+                    expect = all[r].nodes.size();
+                }
+            }
+            Flare::subgraph_t found(-1, -1);
+            bool ret = rg.findEnclosingRegion(pick, found, 0, 100);
+            REQUIRE(ret == (expect != 0));
+            if (ret) {
+                REQUIRE(found.nodes.size() == expect);
+                REQUIRE(std::includes(found.nodes.begin(), found.nodes.end(), pick.begin(), pick.end()));
+            }
+        }
+    }
+}
+
+TEST_CASE("Enclosing region scaling", "[.][benchmark]") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 5000);
+    Flare::subgraph_t region(-1, -1);
+    Flare::intset_t warm = { 0 };
+    REQUIRE(fg.findEnclosingRegion(warm, region, 0, 100) == true);
+    unsigned int seed = 3;
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int q = 0; q < 10000; ++q) {
+        // each region holds every deeper level, so stay near the bottom to keep the
+        // output small
+        seed = seed * 1103515245 + 12345;
+        int level = 4900 + (seed >> 16) % 90;
+        Flare::intset_t nodes = { 3 * level + 1, 3 * (level + 5) + 1 };
+        REQUIRE(fg.findEnclosingRegion(nodes, region, 0, 100) == true);
+        total += region.nodes.size();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("enclosing region, 15k nodes: 10000 queries in %.1f ms (%zu nodes returned)\n", ms, total);
+}
+
+// full node set of group g of a plan, nested groups included
+static void expandGroup(const Flare::collapsePlan_t &plan, int g, Flare::intset_t &out) {
+    out.insert(plan[g].nodes.begin(), plan[g].nodes.end());
+    for (auto it = plan[g].groups.begin(); it != plan[g].groups.end(); ++it) {
+        expandGroup(plan, *it, out);
+    }
+}
+
+TEST_CASE("Simplification plan") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 5);
+    Flare::collapsePlan_t plan;
+    REQUIRE(fg.planSimplification(plan, 10, 0, 100) == true);
+    // innermost level first, each one taking in the group of the level below
+    REQUIRE(plan.size() == 3);
+    for (int g = 0; g < 3; ++g) {
+        int level = 5 - g;
+        REQUIRE(plan[g].n1 == 3 * level);
+        REQUIRE(plan[g].n2 == 3 * level + 2);
+        Flare::intset_t nodes(plan[g].nodes.begin(), plan[g].nodes.end());
+        Flare::intset_t expected = { 3 * level, 3 * level + 1, 3 * level + 2 };
+        REQUIRE(nodes == expected);
+        REQUIRE(plan[g].groups.size() == (g == 0 ? 0 : 1));
+    }
+    REQUIRE(plan[2].groups[0] == 1);
+    REQUIRE(plan[0].visibleNodes == 16);
+    REQUIRE(plan[1].visibleNodes == 13);
+    REQUIRE(plan[2].visibleNodes == 10);
+    REQUIRE(plan[0].label == "<15,17> (3 blocks)");
+
+    REQUIRE(fg.setNodeArea(9, 0x401000, 0x401010) == true);
+    REQUIRE(fg.setNodeArea(11, 0x401040, 0x401048) == true);
+    REQUIRE(fg.planSimplification(plan, 10, 0, 100) == true);
+    REQUIRE(plan[2].label == "0x401000 .. 0x401040 (9 blocks)");
+
+    // already small enough
+    REQUIRE(fg.planSimplification(plan, 18, 0, 100) == true);
+    REQUIRE(plan.size() == 0);
+
+    // chained regions can't both be groups
+    Flare::FlareGraph chain;
+    for (int i = 0; i < 5; ++i) {
+        chain.addNode(i);
+    }
+    for (int i = 0; i < 4; ++i) {
+        chain.addEdge(i, i + 1);
+    }
+    REQUIRE(chain.planSimplification(plan, 0, 0, 100) == true);
+    REQUIRE(plan.size() == 2);
+    REQUIRE(plan[0].n1 == 0);
+    REQUIRE(plan[1].n1 == 2);
+    REQUIRE(plan[1].visibleNodes == 3);
+
+    // every group is one of the findSimpleSubGraphs() subgraphs, groups nest, and
+    // the visible count matches the collapsed graph
+    unsigned int seed = 11;
+    for (int iter = 0; iter < 200; ++iter) {
+        Flare::FlareGraph rg;
+        int count = 6 + iter % 40;
+        for (int i = 0; i < count; ++i) {
+            rg.addNode(i);
+        }
+        for (int i = 0; i + 1 < count; ++i) {
+            seed = seed * 1103515245 + 12345;
+            int to = i + 1 + (seed >> 16) % 3;
+            rg.addEdge(i, to < count ? to : count - 1);
+        }
+        for (int i = 0; i < count / 5; ++i) {
+            seed = seed * 1103515245 + 12345;
+            int from = (seed >> 16) % count;
+            seed = seed * 1103515245 + 12345;
+            int to = (seed >> 16) % count;
+            if (!rg.hasSucc(from, to)) {
+                rg.addEdge(from, to);
+            }
+        }
+        Flare::subgraphVec_t all;
+        REQUIRE(rg.findSimpleSubGraphs(all, 2, 100) == true);
+        REQUIRE(rg.planSimplification(plan, 0, 2, 100) == true);
+
+        std::vector<int> member(count, 0);
+        std::vector<int> taken(plan.size(), 0);
+        for (int g = 0; g < (int)plan.size(); ++g) {
+            for (auto it = plan[g].nodes.begin(); it != plan[g].nodes.end(); ++it) {
+                REQUIRE(member[*it] == 0);
+                member[*it] = 1;
+            }
+            for (auto it = plan[g].groups.begin(); it != plan[g].groups.end(); ++it) {
+                REQUIRE(*it < g);
+                REQUIRE(taken[*it] == 0);
+                taken[*it] = 1;
+            }
+            Flare::intset_t nodes;
+            expandGroup(plan, g, nodes);
+            bool found = false;
+            for (size_t r = 0; r < all.size(); ++r) {
+                if ((all[r].n1 == plan[g].n1) && (all[r].n2 == plan[g].n2)) {
+                    REQUIRE(all[r].nodes == nodes);
+                    found = true;
+                }
+            }
+            REQUIRE(found == true);
+        }
+        int visible = count;
+        for (int i = 0; i < count; ++i) {
+            visible -= member[i];
+        }
+        for (size_t g = 0; g < plan.size(); ++g) {
+            visible += (taken[g] == 0) ? 1 : 0;
+        }
+        REQUIRE(visible == (plan.size() == 0 ? count : plan.back().visibleNodes));
+    }
+}
+
+TEST_CASE("Simplification plan scaling", "[.][benchmark]") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 16666);
+    Flare::collapsePlan_t plan;
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(fg.planSimplification(plan, 50, 3, 100) == true);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("simplification plan, 50k nodes: %zu groups, %d nodes left in %.1f ms\n", plan.size(), plan.back().visibleNodes, ms);
+    REQUIRE(plan.back().visibleNodes <= 50);
+}
+
+TEST_CASE("Contracted groups") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 3);
+    REQUIRE(fg.getVisibleCount() == 12);
+    REQUIRE(fg.isGrouped(9) == false);
+    REQUIRE(fg.groupOf(9) == 9);
+
+    // the innermost level, then the level holding it
+    Flare::intvector_t inner = { 9, 10, 11 };
+    REQUIRE(fg.contractGroup(inner) == 9);
+    REQUIRE(fg.getVisibleCount() == 10);
+    REQUIRE(fg.groupOf(11) == 9);
+    REQUIRE(fg.isGrouped(10) == true);
+    REQUIRE(fg.groupNodeCount(9) == 3);
+    Flare::intvector_t hidden = { 10, 6 };
+    REQUIRE(fg.contractGroup(hidden) == -1);
+    Flare::intvector_t unknown = { 99 };
+    REQUIRE(fg.contractGroup(unknown) == -1);
+
+    Flare::intvector_t outer = { 6, 7, 8, 9 };
+    REQUIRE(fg.contractGroup(outer) == 6);
+    REQUIRE(fg.getVisibleCount() == 7);
+    REQUIRE(fg.groupOf(10) == 6);
+    REQUIRE(fg.groupNodeCount(6) == 6);
+
+    Flare::intvector_t succs;
+    REQUIRE(fg.visibleSuccs(3, succs) == true);
+    std::sort(succs.begin(), succs.end());
+    Flare::intvector_t expected = { 4, 6 };
+    REQUIRE(succs == expected);
+    REQUIRE(fg.visibleSuccs(7, succs) == true);
+    expected = { 5 };
+    REQUIRE(succs == expected);
+    Flare::intvector_t preds;
+    REQUIRE(fg.visiblePreds(6, preds) == true);
+    expected = { 3 };
+    REQUIRE(preds == expected);
+
+    // expanding the outer group brings back the inner one
+    REQUIRE(fg.expandGroup(10) == true);
+    REQUIRE(fg.getVisibleCount() == 10);
+    REQUIRE(fg.groupOf(10) == 9);
+    REQUIRE(fg.groupOf(7) == 7);
+    REQUIRE(fg.expandGroup(7) == false);
+
+    // groups survive changes to the graph
+    fg.addNode(12);
+    fg.addEdge(10, 12);
+    REQUIRE(fg.getVisibleCount() == 11);
+    REQUIRE(fg.visibleSuccs(9, succs) == true);
+    std::sort(succs.begin(), succs.end());
+    expected = { 8, 12 };
+    REQUIRE(succs == expected);
+    fg.clearGroups();
+    REQUIRE(fg.getVisibleCount() == 13);
+
+    // random contractions against the quotient worked out from the groups
+    unsigned int seed = 17;
+    for (int iter = 0; iter < 100; ++iter) {
+        Flare::FlareGraph rg;
+        int count = 10 + iter % 30;
+        for (int i = 0; i < count; ++i) {
+            rg.addNode(i);
+        }
+        for (int i = 0; i < 2 * count; ++i) {
+            seed = seed * 1103515245 + 12345;
+            int from = (seed >> 16) % count;
+            seed = seed * 1103515245 + 12345;
+            int to = (seed >> 16) % count;
+            if (!rg.hasSucc(from, to)) {
+                rg.addEdge(from, to);
+            }
+        }
+        for (int step = 0; step < count / 2; ++step) {
+            Flare::intvector_t visible;
+            rg.visibleNodes(visible);
+            if (visible.size() < 2) {
+                break;
+            }
+            Flare::intvector_t members;
+            for (size_t v = 0; v < visible.size(); ++v) {
+                seed = seed * 1103515245 + 12345;
+                if ((seed >> 16) % 3 == 0) {
+                    members.push_back(visible[v]);
+                }
+            }
+            if (members.size() == 0) {
+                continue;
+            }
+            seed = seed * 1103515245 + 12345;
+            if ((seed >> 16) % 4 == 0) {
+                REQUIRE(rg.expandGroup(members[0]) == rg.isGrouped(members[0]));
+                continue;
+            }
+            REQUIRE(rg.contractGroup(members) == members[0]);
+        }
+        Flare::intvector_t visible;
+        rg.visibleNodes(visible);
+        REQUIRE((int)visible.size() == rg.getVisibleCount());
+        int total = 0;
+        for (size_t v = 0; v < visible.size(); ++v) {
+            total += rg.groupNodeCount(visible[v]);
+        }
+        REQUIRE(total == count);
+        for (size_t v = 0; v < visible.size(); ++v) {
+            Flare::intset_t expect;
+            for (int i = 0; i < count; ++i) {
+                if (rg.groupOf(i) != visible[v]) {
+                    continue;
+                }
+                for (int j = 0; j < rg.nsucc(i); ++j) {
+                    int to = rg.groupOf(rg.succ(i, j));
+                    if (to != visible[v]) {
+                        expect.insert(to);
+                    }
+                }
+            }
+            Flare::intvector_t got;
+            REQUIRE(rg.visibleSuccs(visible[v], got) == true);
+            REQUIRE(got.size() == expect.size());
+            REQUIRE(Flare::intset_t(got.begin(), got.end()) == expect);
+        }
+    }
+}
+
+TEST_CASE("Contracted group scaling", "[.][benchmark]") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 16666);
+    Flare::collapsePlan_t plan;
+    REQUIRE(fg.planSimplification(plan, 50, 3, 100) == true);
+    Flare::intvector_t groupNames(plan.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t g = 0; g < plan.size(); ++g) {
+        Flare::intvector_t members(plan[g].nodes.begin(), plan[g].nodes.end());
+        for (auto it = plan[g].groups.begin(); it != plan[g].groups.end(); ++it) {
+            members.push_back(groupNames[*it]);
+        }
+        groupNames[g] = fg.contractGroup(members);
+        REQUIRE(groupNames[g] >= 0);
+    }
+    Flare::intvector_t visible;
+    Flare::intvector_t succs;
+    fg.visibleNodes(visible);
+    size_t edges = 0;
+    for (auto it = visible.begin(); it != visible.end(); ++it) {
+        fg.visibleSuccs(*it, succs);
+        edges += succs.size();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("contracted groups, 50k nodes: %zu groups, %zu visible nodes, %zu edges in %.1f ms\n", plan.size(), visible.size(), edges, ms);
+    REQUIRE((int)visible.size() == plan.back().visibleNodes);
+}
+
+BOOST_CONCEPT_ASSERT((boost::BidirectionalGraphConcept<Flare::FrozenGraph>));
+BOOST_CONCEPT_ASSERT((boost::AdjacencyGraphConcept<Flare::FrozenGraph>));
+BOOST_CONCEPT_ASSERT((boost::VertexListGraphConcept<Flare::FrozenGraph>));
+BOOST_CONCEPT_ASSERT((boost::EdgeListGraphConcept<Flare::FrozenGraph>));
+BOOST_CONCEPT_ASSERT((boost::BidirectionalGraphConcept<Flare::ReversedFrozenGraph>));
+
+TEST_CASE("Boost graph adapter") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 4);
+    const Flare::FrozenGraph &g = fg.getFrozenGraph();
+    REQUIRE(num_vertices(g) == 15u);
+    REQUIRE((int)num_edges(g) == fg.getEdgeCount());
+    int edgeCount = 0;
+    BGL_FORALL_EDGES(e, g, Flare::FrozenGraph) {
+        REQUIRE(fg.hasSucc(source(e, g), target(e, g)) == true);
+        ++edgeCount;
+    }
+    REQUIRE(edgeCount == fg.getEdgeCount());
+    BGL_FORALL_VERTICES(v, g, Flare::FrozenGraph) {
+        REQUIRE((int)out_degree(v, g) == fg.nsucc(v));
+        REQUIRE((int)in_degree(v, g) == fg.npred(v));
+        BGL_FORALL_INEDGES(v, e, g, Flare::FrozenGraph) {
+            REQUIRE(target(e, g) == v);
+            REQUIRE(fg.hasSucc(source(e, g), v) == true);
+        }
+    }
+
+    // every edge goes forward in a topological order
+    std::vector<int> topo;
+    boost::topological_sort(g, std::back_inserter(topo));
+    REQUIRE(topo.size() == 15);
+    std::vector<int> position(15);
+    for (int i = 0; i < 15; ++i) {
+        // topological_sort writes the vertices in reverse
+        position[topo[i]] = 14 - i;
+    }
+    BGL_FORALL_EDGES(e, g, Flare::FrozenGraph) {
+        REQUIRE(position[source(e, g)] < position[target(e, g)]);
+    }
+
+    // Boost's dominators against ours, and post-dominators on the reversed view
+    std::vector<int> bidom(15, -1);
+    boost::lengauer_tarjan_dominator_tree(g, 0, boost::make_iterator_property_map(bidom.begin(), get(boost::vertex_index, g)));
+    Flare::intvector_t idom;
+    REQUIRE(fg.idom(idom, 0) == true);
+    REQUIRE(bidom == idom);
+    Flare::ReversedFrozenGraph rg = Flare::reversed(g);
+    std::vector<int> bipdom(15, -1);
+    boost::lengauer_tarjan_dominator_tree(rg, 2, boost::make_iterator_property_map(bipdom.begin(), get(boost::vertex_index, rg)));
+    Flare::intvector_t ipdom;
+    REQUIRE(fg.ipdom(ipdom, 2) == true);
+    REQUIRE(bipdom == ipdom);
+
+    // same component partition as stronglyConnectedComponents()
+    unsigned int seed = 23;
+    for (int iter = 0; iter < 50; ++iter) {
+        Flare::FlareGraph cg;
+        int count = 5 + iter;
+        for (int i = 0; i < count; ++i) {
+            cg.addNode(i);
+        }
+        for (int i = 0; i < 2 * count; ++i) {
+            seed = seed * 1103515245 + 12345;
+            int from = (seed >> 16) % count;
+            seed = seed * 1103515245 + 12345;
+            int to = (seed >> 16) % count;
+            if (!cg.hasSucc(from, to)) {
+                cg.addEdge(from, to);
+            }
+        }
+        Flare::intvector_t ours;
+        int components = cg.stronglyConnectedComponents(ours);
+        const Flare::FrozenGraph &cfg = cg.getFrozenGraph();
+        std::vector<int> theirs(count);
+        int bcomponents = boost::strong_components(cfg, boost::make_iterator_property_map(theirs.begin(), get(boost::vertex_index, cfg)));
+        REQUIRE(bcomponents == components);
+        for (int a = 0; a < count; ++a) {
+            for (int b = a + 1; b < count; ++b) {
+                REQUIRE((ours[a] == ours[b]) == (theirs[a] == theirs[b]));
+            }
+        }
+    }
+}
+
+// same nodes with the same successors and predecessors, in the same order
+static void requireSameAdjacency(Flare::FlareGraph &a, Flare::FlareGraph &b, const Flare::intvector_t &names) {
+    REQUIRE(a.getNodeCount() == b.getNodeCount());
+    REQUIRE(a.getEdgeCount() == b.getEdgeCount());
+    for (auto it = names.begin(); it != names.end(); ++it) {
+        REQUIRE(a.nsucc(*it) == b.nsucc(*it));
+        for (int j = 0; j < a.nsucc(*it); ++j) {
+            REQUIRE(a.succ(*it, j) == b.succ(*it, j));
+        }
+        REQUIRE(a.npred(*it) == b.npred(*it));
+        for (int j = 0; j < a.npred(*it); ++j) {
+            REQUIRE(a.pred(*it, j) == b.pred(*it, j));
+        }
+    }
+}
+
+TEST_CASE("Bulk graph construction") {
+    // random edges with plenty of repeats and self loops
+    int count = 40;
+    Flare::intvector_t names;
+    Flare::intvector_t sources;
+    Flare::intvector_t targets;
+    for (int i = 0; i < count; ++i) {
+        names.push_back(i);
+    }
+    unsigned int seed = 5;
+    for (int i = 0; i < 300; ++i) {
+        seed = seed * 1103515245 + 12345;
+        sources.push_back((seed >> 16) % count);
+        seed = seed * 1103515245 + 12345;
+        targets.push_back((seed >> 16) % 12);
+    }
+    Flare::FlareGraph incremental;
+    for (int i = 0; i < count; ++i) {
+        incremental.addNode(i);
+    }
+    for (size_t e = 0; e < sources.size(); ++e) {
+        if (!incremental.hasSucc(sources[e], targets[e])) {
+            incremental.addEdge(sources[e], targets[e]);
+        }
+    }
+    Flare::FlareGraph bulk;
+    REQUIRE(bulk.build(count, sources, targets) == true);
+    requireSameAdjacency(bulk, incremental, names);
+
+    // added in two rounds, the second one dedupes against the first
+    Flare::intvector_t firstSources(sources.begin(), sources.begin() + 150);
+    Flare::intvector_t firstTargets(targets.begin(), targets.begin() + 150);
+    Flare::intvector_t restSources(sources.begin() + 150, sources.end());
+    Flare::intvector_t restTargets(targets.begin() + 150, targets.end());
+    Flare::FlareGraph halves;
+    REQUIRE(halves.build(count, firstSources, firstTargets) == true);
+    REQUIRE(halves.addEdges(restSources, restTargets) == true);
+    requireSameAdjacency(halves, incremental, names);
+    REQUIRE(halves.addEdges(sources, targets) == true);
+    requireSameAdjacency(halves, incremental, names);
+
+    // nothing is added when any edge is bad
+    int edgeCount = halves.getEdgeCount();
+    Flare::intvector_t badSources;
+    Flare::intvector_t badTargets;
+    badSources.push_back(0);
+    badTargets.push_back(39);
+    badSources.push_back(0);
+    badTargets.push_back(count);
+    REQUIRE(halves.addEdges(badSources, badTargets) == false);
+    REQUIRE(halves.hasSucc(0, 39) == incremental.hasSucc(0, 39));
+    REQUIRE(halves.getEdgeCount() == edgeCount);
+    badSources.pop_back();
+    REQUIRE(halves.addEdges(badSources, badTargets) == false);
+    Flare::FlareGraph empty;
+    REQUIRE(empty.build(-1, sources, targets) == false);
+    REQUIRE(empty.getNodeCount() == 0);
+    Flare::intvector_t badNames;
+    badNames.push_back(1);
+    badNames.push_back(-1);
+    REQUIRE(empty.addNodes(badNames) == false);
+    REQUIRE(empty.getNodeCount() == 0);
+
+    // sparse names, repeated names and the pair list
+    Flare::FlareGraph sparse;
+    Flare::intvector_t sparseNames;
+    sparseNames.push_back(100);
+    sparseNames.push_back(5);
+    sparseNames.push_back(7);
+    sparseNames.push_back(100);
+    REQUIRE(sparse.addNodes(sparseNames) == true);
+    REQUIRE(sparse.getNodeCount() == 3);
+    std::vector<Flare::intintPair_t> pairs;
+    pairs.push_back(std::make_pair(100, 5));
+    pairs.push_back(std::make_pair(5, 7));
+    pairs.push_back(std::make_pair(100, 5));
+    pairs.push_back(std::make_pair(7, 100));
+    REQUIRE(sparse.addEdges(pairs) == true);
+    REQUIRE(sparse.getEdgeCount() == 3);
+    REQUIRE(sparse.succ(100, 0) == 5);
+    REQUIRE(sparse.pred(100, 0) == 7);
+    REQUIRE(sparse.hasSucc(5, 7) == true);
+
+    // the text loader builds the same graph as before
+    std::stringstream dot;
+    REQUIRE(incremental.storeGraphViz(dot) == true);
+    Flare::FlareGraph loaded;
+    REQUIRE(loaded.loadGraphViz(dot) == true);
+    REQUIRE(loaded.getEdgeCount() == incremental.getEdgeCount());
+    for (size_t e = 0; e < sources.size(); ++e) {
+        REQUIRE(loaded.hasSucc(sources[e], targets[e]) == true);
+    }
+}
+
+TEST_CASE("Bulk construction scaling", "[.][benchmark]") {
+    // a call graph sized graph: 100k nodes, 1M edges, about 1% of them repeats
+    int count = 100000;
+    Flare::intvector_t sources;
+    Flare::intvector_t targets;
+    unsigned int seed = 17;
+    for (int i = 0; i < 1000000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        sources.push_back((seed >> 8) % count);
+        seed = seed * 1103515245 + 12345;
+        targets.push_back((seed >> 8) % count);
+    }
+    auto start = std::chrono::steady_clock::now();
+    Flare::FlareGraph bulk;
+    REQUIRE(bulk.build(count, sources, targets) == true);
+    double bulkMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    Flare::FlareGraph incremental;
+    for (int i = 0; i < count; ++i) {
+        incremental.addNode(i);
+    }
+    for (size_t e = 0; e < sources.size(); ++e) {
+        if (!incremental.hasSucc(sources[e], targets[e])) {
+            incremental.addEdge(sources[e], targets[e]);
+        }
+    }
+    double incrementalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("bulk build, %d edges: %.1f ms, one at a time %.1f ms\n", bulk.getEdgeCount(), bulkMs, incrementalMs);
+    REQUIRE(bulk.getEdgeCount() == incremental.getEdgeCount());
+}
+
+TEST_CASE("Shared graph structure") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 4);
+    fg.setNodeArea(3, 0x1000, 0x1010);
+    fg.setFunctionEa(0x1000);
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    REQUIRE(fg.freeze() == true);
+    const int *targets = fg.getFrozenGraph().succTargets.data();
+
+    // load() shares the structure, but none of the properties
+    Flare::FlareGraph copy;
+    REQUIRE(copy.load(fg) == true);
+    REQUIRE(copy.getNodeCount() == 15);
+    REQUIRE(copy.getEdgeCount() == fg.getEdgeCount());
+    REQUIRE(copy.getFunctionEa() == 0x1000);
+    REQUIRE(copy.getNodeAreaStart(3) == 0x1000);
+    REQUIRE(copy.getRootNode() == -1);
+    REQUIRE(copy.getFrozenGraph().succTargets.data() == targets);
+    Flare::intvector_t idom;
+    Flare::intvector_t copyIdom;
+    REQUIRE(fg.idom(idom, 0) == true);
+    REQUIRE(copy.idom(copyIdom, 0) == true);
+    REQUIRE(copyIdom == idom);
+    REQUIRE(copy.getFrozenGraph().succTargets.data() == targets);
+
+    // changing either graph leaves the other one alone
+    REQUIRE(copy.addEdge(1, 4) == true);
+    REQUIRE(copy.hasSucc(1, 4) == true);
+    REQUIRE(fg.hasSucc(1, 4) == false);
+    REQUIRE(fg.frozenValid() == true);
+    copy.setNodeArea(3, 0x2000, 0x2010);
+    REQUIRE(fg.getNodeAreaStart(3) == 0x1000);
+
+    // snapshots stay as they were taken
+    Flare::GraphSnapshot snap = fg.snapshot();
+    REQUIRE(snap->frozenValid() == true);
+    REQUIRE(&snap->getFrozenGraph() == &fg.getFrozenGraph());
+    Flare::FlareGraph fromSnap;
+    REQUIRE(fromSnap.load(snap) == true);
+    REQUIRE(fromSnap.getFrozenGraph().succTargets.data() == targets);
+    REQUIRE(fromSnap.getFunctionEa() == (Flare::fea_t)-1);
+    REQUIRE(fg.addNode(100) == 15);
+    REQUIRE(fg.addEdge(2, 100) == true);
+    REQUIRE(snap->getNodeCount() == 15);
+    REQUIRE(snap->frozenValid() == true);
+    REQUIRE(fromSnap.getNodeCount() == 15);
+    REQUIRE(fromSnap.hasSucc(2, 100) == false);
+    REQUIRE(fg.getNodeCount() == 16);
+    Flare::FlareGraph empty;
+    REQUIRE(empty.load(Flare::GraphSnapshot()) == false);
+
+    // an unfrozen graph is copied by whichever side freezes first
+    Flare::FlareGraph unfrozen;
+    buildNested(unfrozen, 2);
+    Flare::FlareGraph loaded;
+    REQUIRE(loaded.load(unfrozen) == true);
+    REQUIRE(loaded.freeze() == true);
+    REQUIRE(loaded.frozenValid() == true);
+    REQUIRE(unfrozen.frozenValid() == false);
+}
+
+TEST_CASE("Moving graphs") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 4);
+    fg.addNode(100);
+    fg.addEdge(2, 100);
+    fg.setFunctionEa(0x1000);
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    Flare::intvector_t idom;
+    REQUIRE(fg.idom(idom, 0) == true);
+    unsigned int generation = fg.getStructureGeneration();
+    const int *targets = fg.getFrozenGraph().succTargets.data();
+
+    Flare::FlareGraph moved(std::move(fg));
+    REQUIRE(moved.getNodeCount() == 16);
+    REQUIRE(moved.getRootNode() == 0);
+    REQUIRE(moved.getFunctionEa() == 0x1000);
+    REQUIRE(moved.hasSucc(2, 100) == true);
+    REQUIRE(moved.getStructureGeneration() == generation);
+    REQUIRE(moved.getFrozenGraph().succTargets.data() == targets);
+    Flare::intvector_t movedIdom;
+    REQUIRE(moved.idom(movedIdom, 0) == true);
+    REQUIRE(movedIdom == idom);
+
+    // the moved-from graph is empty and can be used again
+    REQUIRE(fg.getNodeCount() == 0);
+    REQUIRE(fg.getEdgeCount() == 0);
+    REQUIRE(fg.getRootNode() == -1);
+    REQUIRE(fg.addNode(7) == 0);
+
+    Flare::FlareGraph assigned;
+    buildNested(assigned, 1);
+    assigned = std::move(moved);
+    REQUIRE(assigned.getNodeCount() == 16);
+    REQUIRE(assigned.hasSucc(2, 100) == true);
+    REQUIRE(assigned.getNodeAreaStart(100) == 0);
+    REQUIRE(moved.getNodeCount() == 0);
+    std::vector<Flare::FlareGraph> graphs;
+    graphs.push_back(std::move(assigned));
+    graphs.push_back(Flare::FlareGraph());
+    REQUIRE(graphs[0].getNodeCount() == 16);
+}
+
+TEST_CASE("Shared structure scaling", "[.][benchmark]") {
+    // the plugin's pattern: one cached function graph, loaded again for every action
+    Flare::FlareGraph cached;
+    Flare::intvector_t sources;
+    Flare::intvector_t targets;
+    unsigned int seed = 31;
+    int count = 100000;
+    for (int i = 0; i < 4 * count; ++i) {
+        seed = seed * 1103515245 + 12345;
+        sources.push_back((seed >> 8) % count);
+        seed = seed * 1103515245 + 12345;
+        targets.push_back((seed >> 8) % count);
+    }
+    REQUIRE(cached.build(count, sources, targets) == true);
+    REQUIRE(cached.freeze() == true);
+    auto start = std::chrono::steady_clock::now();
+    int edges = 0;
+    for (int i = 0; i < 1000; ++i) {
+        Flare::FlareGraph fg;
+        fg.load(cached);
+        fg.addNodeProp(i, Flare::NodeProperty::Root);
+        edges += fg.getFrozenGraph().edgeCount();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("shared structure, %d edges: 1000 loads in %.2f ms\n", cached.getEdgeCount(), ms);
+    REQUIRE(edges == 1000 * cached.getEdgeCount());
+}
+
+TEST_CASE("Node attributes") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 4);
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    REQUIRE(fg.hasNodeProp(0, Flare::NodeProperty::Root) == true);
+    REQUIRE(fg.hasNodeProp(0, Flare::NodeProperty::Sentry) == false);
+    REQUIRE(fg.hasNodeProp(99, Flare::NodeProperty::Root) == false);
+
+    // sentries cut the reachable set and can be taken out again
+    fg.addNodeProp(3, Flare::NodeProperty::Sentry);
+    fg.addNodeProp(6, Flare::NodeProperty::Sentry);
+    fg.addNodeProp(6, Flare::NodeProperty::Sentry);
+    fg.addNodeProp(9, Flare::NodeProperty::Sentry);
+    REQUIRE(fg.getSentryCount() == 3);
+    Flare::intset_t reach;
+    REQUIRE(fg.reachable(reach) == true);
+    Flare::intset_t expect = { 0, 1, 2 };
+    REQUIRE(reach == expect);
+    REQUIRE(fg.clearNodeProp(3, Flare::NodeProperty::Sentry) == true);
+    REQUIRE(fg.hasNodeProp(3, Flare::NodeProperty::Sentry) == false);
+    REQUIRE(fg.getSentryCount() == 2);
+    Flare::intset_t sentries;
+    for (int i = 0; i < fg.getSentryCount(); ++i) {
+        sentries.insert(fg.getSentry(i));
+    }
+    Flare::intset_t expectSentries = { 6, 9 };
+    REQUIRE(sentries == expectSentries);
+    reach.clear();
+    REQUIRE(fg.reachable(reach) == true);
+    Flare::intset_t expect2 = { 0, 1, 2, 3, 4, 5 };
+    REQUIRE(reach == expect2);
+    fg.clearNodeProp(6, Flare::NodeProperty::Sentry);
+    fg.clearNodeProp(9, Flare::NodeProperty::Sentry);
+    fg.clearNodeProp(9, Flare::NodeProperty::Sentry);
+    REQUIRE(fg.getSentryCount() == 0);
+    reach.clear();
+    REQUIRE(fg.reachable(reach) == true);
+    REQUIRE(reach.size() == 15);
+
+    // there is only ever one root
+    fg.addNodeProp(3, Flare::NodeProperty::Root);
+    REQUIRE(fg.getRootNode() == 3);
+    REQUIRE(fg.hasNodeProp(0, Flare::NodeProperty::Root) == false);
+    fg.clearNodeProp(0, Flare::NodeProperty::Root);
+    REQUIRE(fg.getRootNode() == 3);
+
+    // nodes added after the attributes, and interned raw colors
+    REQUIRE(fg.addNode(100) == 15);
+    fg.addEdge(2, 100);
+    fg.addNodeProp(100, Flare::NodeProperty::Selected);
+    REQUIRE(fg.hasNodeProp(100, Flare::NodeProperty::Selected) == true);
+    std::ostringstream props;
+    REQUIRE(fg.storeGraphViz(props) == true);
+    REQUIRE(props.str().find("    3 [ style=\"filled\" fillcolor=\"green\"]\n") != std::string::npos);
+    REQUIRE(props.str().find("    100 [ style=\"filled\" fillcolor=\"lightskyblue\"]\n") != std::string::npos);
+    REQUIRE(props.str().find("\"green\"", props.str().find("\"green\"") + 1) == std::string::npos);
+
+    Flare::FlareGraph colored;
+    buildNested(colored, 1);
+    colored.colorNode(1, "red");
+    colored.colorNode(4, "blue");
+    colored.colorNode(2, "red");
+    colored.colorNode(4, "red");
+    std::ostringstream colors;
+    REQUIRE(colored.storeGraphViz(colors) == true);
+    REQUIRE(colors.str().find("    1 [ style=\"filled\" fillcolor=\"red\"]\n") != std::string::npos);
+    REQUIRE(colors.str().find("    2 [ style=\"filled\" fillcolor=\"red\"]\n") != std::string::npos);
+    REQUIRE(colors.str().find("    4 [ style=\"filled\" fillcolor=\"red\"]\n") != std::string::npos);
+    REQUIRE(colors.str().find("blue") == std::string::npos);
+}
+
+TEST_CASE("Sentry toggling scaling", "[.][benchmark]") {
+    // a long chain with every other node a sentry, cleared one at a time
+    Flare::FlareGraph fg;
+    Flare::intvector_t sources;
+    Flare::intvector_t targets;
+    int count = 100000;
+    for (int i = 0; i + 1 < count; ++i) {
+        sources.push_back(i);
+        targets.push_back(i + 1);
+    }
+    REQUIRE(fg.build(count, sources, targets) == true);
+    fg.addNodeProp(0, Flare::NodeProperty::Root);
+    for (int i = 1; i < count; i += 2) {
+        fg.addNodeProp(i, Flare::NodeProperty::Sentry);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 1; i < count; i += 2) {
+        fg.clearNodeProp(i, Flare::NodeProperty::Sentry);
+    }
+    Flare::intset_t reach;
+    REQUIRE(fg.reachable(reach) == true);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("sentries, %d nodes: %d cleared and reachable in %.1f ms\n", count, count / 2, ms);
+    REQUIRE((int)reach.size() == count);
+}
+
+// counts every heap allocation in the test program, so tests can check that
+// code paths which shouldn't allocate really don't
+static std::atomic<size_t> g_heapAllocations(0);
+
+// the replacements below hand out malloc() memory, so the compiler sees every
+// inlined new/delete pair as a mismatch
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size) {
+    ++g_heapAllocations;
+    void *p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) throw() {
+    ++g_heapAllocations;
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) throw() {
+    return operator new(size, tag);
+}
+
+void operator delete(void *p) throw() {
+    std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) throw() {
+    std::free(p);
+}
+
+void operator delete[](void *p) throw() {
+    std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) throw() {
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic pop
+#endif
+
+TEST_CASE("Analysis workspace") {
+    Flare::AnalysisWorkspace ws;
+    {
+        // nested scopes give back their memory in order
+        Flare::AnalysisWorkspace::Scope outer(ws);
+        Flare::arenaIntvector_t a(100, 1, Flare::ArenaAllocator<int>(ws));
+        {
+            Flare::AnalysisWorkspace::Scope inner(ws);
+            Flare::arenaIntvector_t b(1000000, 2, Flare::ArenaAllocator<int>(ws));
+            REQUIRE(ws.getHeapAllocations() == 2);
+        }
+        Flare::arenaIntvector_t c(100, 3, Flare::ArenaAllocator<int>(ws));
+        REQUIRE(a[99] == 1);
+        REQUIRE(c[99] == 3);
+        REQUIRE(((size_t)c.data() % std::alignment_of<int>::value) == 0);
+    }
+    // the two blocks were merged into one that fits both
+    REQUIRE(ws.getHeapAllocations() == 3);
+    size_t capacity = ws.getCapacity();
+    {
+        Flare::AnalysisWorkspace::Scope scope(ws);
+        Flare::arenaIntvector_t a(100, 1, Flare::ArenaAllocator<int>(ws));
+        Flare::arenaIntvector_t b(1000000, 2, Flare::ArenaAllocator<int>(ws));
+    }
+    REQUIRE(ws.getHeapAllocations() == 3);
+    REQUIRE(ws.getCapacity() == capacity);
+
+    // repeated analyses settle on the workspace they have and stop allocating
+    Flare::FlareGraph fg;
+    buildNested(fg, 2000);
+    Flare::subgraphVec_t first;
+    Flare::subgraphVec_t out;
+    REQUIRE(fg.findSimpleSubGraphs(first, 0, 100, ws) == true);
+    REQUIRE(fg.findSimpleSubGraphs(out, 0, 100, ws) == true);
+    size_t blocks = ws.getHeapAllocations();
+    for (int i = 0; i < 5; ++i) {
+        out.clear();
+        REQUIRE(fg.findSimpleSubGraphs(out, 0, 100, ws) == true);
+        REQUIRE(out.size() == first.size());
+    }
+    REQUIRE(ws.getHeapAllocations() == blocks);
+    for (size_t i = 0; i < out.size(); ++i) {
+        REQUIRE(out[i].n1 == first[i].n1);
+        REQUIRE(out[i].n2 == first[i].n2);
+        REQUIRE(out[i].nodes == first[i].nodes);
+    }
+
+    // with limits nothing passes there is no output either, so nothing at all
+    // may be allocated
+    size_t before = g_heapAllocations;
+    Flare::intvector_t probe(10, 1);
+    REQUIRE(g_heapAllocations == before + 1);
+    Flare::subgraphVec_t none;
+    REQUIRE(fg.findSimpleSubGraphs(none, 1000000, 100) == true);
+    before = g_heapAllocations;
+    for (int i = 0; i < 5; ++i) {
+        REQUIRE(fg.findSimpleSubGraphs(none, 1000000, 100) == true);
+    }
+    size_t allocations = g_heapAllocations - before;
+    REQUIRE(allocations == 0);
+    REQUIRE(none.empty());
+
+    // the same regions as the PerRoot candidate checks
+    Flare::FlareGraph perRoot;
+    buildNested(perRoot, 20);
+    perRoot.setDomMode(Flare::DomMode::PerRoot);
+    Flare::subgraphVec_t perRootOut;
+    REQUIRE(perRoot.findSimpleSubGraphs(perRootOut, 0, 100, ws) == true);
+    REQUIRE(perRootOut.size() == 21);
+    Flare::subgraphVec_t regions;
+    perRoot.setDomMode(Flare::DomMode::VirtualRoot);
+    REQUIRE(perRoot.findSimpleSubGraphs(regions, 0, 100) == true);
+    REQUIRE(regions.size() == perRootOut.size());
+    for (size_t i = 0; i < regions.size(); ++i) {
+        REQUIRE(regions[i].n1 == perRootOut[i].n1);
+        REQUIRE(regions[i].nodes == perRootOut[i].nodes);
+    }
+}
+
+TEST_CASE("Analysis workspace scaling", "[.][benchmark]") {
+    Flare::FlareGraph fg;
+    buildNested(fg, 16666);
+    Flare::subgraphVec_t out;
+    REQUIRE(fg.findSimpleSubGraphs(out, 1000000, 100) == true);
+    size_t before = g_heapAllocations;
+    bool ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i) {
+        ok = fg.findSimpleSubGraphs(out, 1000000, 100) && ok;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    REQUIRE(ok);
+    printf("region scan, 50k nodes: 100 calls in %.1f ms with %d heap allocations\n", ms, (int)(g_heapAllocations - before));
+}